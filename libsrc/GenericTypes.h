@@ -26,11 +26,39 @@
 
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QSharedPointer>
+#include <QIODevice>
 #include "libTargomanCommon/clsCountAndSpeed.h"
 #include "QHttp/qhttpfwd.hpp"
 #include "QHttp/tmplAPIArg.h"
 
 namespace QHttp {
+namespace Private {
+struct stuAsyncResponseState;
+class clsRequestHandler;
+class clsBodyStream;
+}
+
+/**
+ * @brief The stuQueueStatistics struct holds API executor queue statistics of a module
+ */
+struct stuQueueStatistics {
+    qint64  Depth = 0;          ///< Number of jobs waiting in queue
+    quint64 Dequeued = 0;       ///< Number of jobs which have been started
+    quint64 TotalWaitMSecs = 0; ///< Sum of the time jobs spent in queue
+    quint64 MaxWaitMSecs = 0;   ///< Maximum time a job spent in queue
+};
+
+/**
+ * @brief The stuUploadStorageStatistics struct holds live disk usage of upload spool files
+ */
+struct stuUploadStorageStatistics {
+    qint64  SpooledBytes = 0;   ///< Bytes held on spool files of in-flight (or not yet cleaned) uploads
+    quint32 SpooledFiles = 0;   ///< Number of open spool files
+    quint32 PendingCleanup = 0; ///< Number of spool files waiting to be released by the cleanup thread
+    quint64 Rejected = 0;       ///< Number of uploads rejected due to MaxSpooledUploadBytes
+};
+
 /**
  * @brief The stuStatistics struct holds server statistics about APIs
  */
@@ -39,11 +67,14 @@ struct stuStatistics {
     Targoman::Common::clsCountAndSpeed WSConnections;
     Targoman::Common::clsCountAndSpeed Errors;
     Targoman::Common::clsCountAndSpeed Blocked;
+    Targoman::Common::clsCountAndSpeed Shed;
     Targoman::Common::clsCountAndSpeed Success;
 
     QHash<QByteArray, Targoman::Common::clsCountAndSpeed> APICallsStats;
     QHash<QByteArray, Targoman::Common::clsCountAndSpeed> APIInternalCacheStats;
     QHash<QByteArray, Targoman::Common::clsCountAndSpeed> APICentralCacheStats;
+    QHash<QByteArray, stuQueueStatistics>                 APIQueueStats;
+    stuUploadStorageStatistics                            UploadStorage;
 };
 
 /**********************************************************************/
@@ -88,6 +119,61 @@ QHTTP_ADD_SIMPLE_TYPE(QString, Date_t);
 QHTTP_ADD_SIMPLE_TYPE(QString, Time_t);
 QHTTP_ADD_SIMPLE_TYPE(QString, DateTime_t);
 
+/**********************************************************************/
+/**
+ * @brief The AsyncResponse_t class is a completion handle which can be used as a parameter of ASYNC_API methods. The connection
+ *        will be parked, without blocking any thread, until resolve"()" or reject"()" is called on any copy of the handle.
+ *        Only the first call will be delivered and if all copies are destroyed unresolved an internal server error will be sent.
+ */
+class AsyncResponse_t{
+public:
+    AsyncResponse_t(){}
+
+    void resolve(const QVariant& _result) const;
+    void reject(const Targoman::Common::exTargomanBase& _exception) const;
+    void reject(quint16 _httpCode, const QString& _message) const;
+    inline bool isValid() const {return this->State.isNull() == false;}
+
+private:
+    AsyncResponse_t(QObject* _requestHandler, qhttp::TStatusCode _code);
+
+private:
+    QSharedPointer<Private::stuAsyncResponseState> State;
+
+    friend class Private::clsRequestHandler;
+};
+
+/**********************************************************************/
+/**
+ * @brief The BodyStream_t class can be used as a parameter of APIs willing to consume request body (including chunked
+ *        transfer-encoded bodies) while it is being received. Body of such APIs is not parsed to arguments and any content
+ *        type is accepted. APIs invoked on worker threads (or async APIs) are invoked as soon as headers are received so
+ *        they can block on device"()"->waitForReadyRead"()" or connect to readyRead and readChannelFinished signals. Others
+ *        are invoked when the whole body has been received. Reading from socket is paused while more than
+ *        BodyStreamBufferSize bytes are waiting to be read by the API.
+ */
+class BodyStream_t{
+public:
+    BodyStream_t(){}
+
+    QIODevice* device() const;
+    inline bool isValid() const {return this->Stream.isNull() == false;}
+    /**
+     * @brief isAborted returns true when the body was truncated because the client disconnected or the request was
+     *        finished before the body was consumed. Aborted streams report end of data so this must be checked on EOF
+     */
+    bool isAborted() const;
+    QString errorString() const;
+
+private:
+    BodyStream_t(const QSharedPointer<Private::clsBodyStream>& _stream) : Stream(_stream) {}
+
+private:
+    QSharedPointer<Private::clsBodyStream> Stream;
+
+    friend class Private::clsRequestHandler;
+};
+
 /**********************************************************************/
 extern void registerGenericTypes();
 }
@@ -112,6 +198,8 @@ Q_DECLARE_METATYPE(QHttp::Date_t)
 Q_DECLARE_METATYPE(QHttp::Time_t)
 Q_DECLARE_METATYPE(QHttp::DateTime_t)
 Q_DECLARE_METATYPE(QHttp::Base64Image_t)
+Q_DECLARE_METATYPE(QHttp::AsyncResponse_t)
+Q_DECLARE_METATYPE(QHttp::BodyStream_t)
 
 
 #endif // QHTTP_GENERICTYPES_H
@@ -29,6 +29,7 @@
 #include <QString>
 #include <QVariant>
 #include <QHash>
+#include <QReadWriteLock>
 
 #include "Private/Configs.hpp"
 #include "Private/intfCacheConnector.hpp"
@@ -52,16 +53,15 @@ class InternalCache
 {
 public:
     static void setValue(const QString& _key, const QVariant& _value, qint32 _ttl){
-        QMutexLocker Locker(&InternalCache::Lock);
+        QWriteLocker Locker(&InternalCache::Lock);
         if(InternalCache::Cache.size() < (int)gConfigs.Public.MaxCachedItems)
            InternalCache::Cache.insert(_key, stuCacheValue(_value, _ttl));
     }
     static QVariant storedValue(const QString& _key){
-        QMutexLocker Locker(&InternalCache::Lock);
-        auto StoredValue = InternalCache::Cache.find(_key);
-        if(StoredValue == InternalCache::Cache.end())
+        QReadLocker Locker(&InternalCache::Lock);
+        auto StoredValue = InternalCache::Cache.constFind(_key);
+        if(StoredValue == InternalCache::Cache.constEnd())
             return QVariant();
-        Locker.unlock();
         if(StoredValue->InsertionTime.secsTo(QTime::currentTime()) > StoredValue->TTL)
             return QVariant();
         return StoredValue->Value;
@@ -69,7 +69,7 @@ public:
 
 public:
     static Cache_t Cache;
-    static QMutex  Lock;
+    static QReadWriteLock Lock;
 
     friend class clsUpdateAndPruneThread;
 };
@@ -80,15 +80,21 @@ public:
     static bool isValid(){return CentralCache::Connector.isNull() == false;}
     static void setup(intfCacheConnector* _connector){ CentralCache::Connector.reset(_connector); }
     static void setValue(const QString& _key, const QVariant& _value, qint32 _ttl){
-        if(CentralCache::Connector.isNull() == false)
+        if(CentralCache::Connector.isNull() == false){
+            QMutexLocker Locker(&CentralCache::Lock);
             CentralCache::Connector->setKeyVal(_key, _value, _ttl);
+        }
     }
     static QVariant storedValue(const QString& _key){
-        return CentralCache::Connector.isNull() ? QVariant() : CentralCache::Connector->getValue(_key);
+        if(CentralCache::Connector.isNull())
+            return QVariant();
+        QMutexLocker Locker(&CentralCache::Lock);
+        return CentralCache::Connector->getValue(_key);
     }
 
 private:
     static QScopedPointer<intfCacheConnector> Connector;
+    static QMutex Lock;
 };
 
 }
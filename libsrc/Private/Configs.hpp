@@ -26,6 +26,8 @@
 
 #include <QTimer>
 #include <QMap>
+#include <QMutex>
+#include <QAtomicInt>
 
 #include "libTargomanCommon/Macros.h"
 #include "libTargomanCommon/exTargomanBase.h"
@@ -44,11 +46,26 @@ struct stuConfigs
     struct stuPrivate{
         QString BasePathWithVersion;
         bool IsStarted = false;
+        QAtomicInt IsDraining;
     } Private;
 };
 
 extern stuConfigs gConfigs;
 extern stuStatistics gServerStats;
+extern QMutex gServerStatsLock;
+
+/**
+ * @brief incServerStat helpers must be used to update gServerStats as it is shared between all IO threads
+ */
+inline void incServerStat(Targoman::Common::clsCountAndSpeed& _stat){
+    QMutexLocker Locker(&gServerStatsLock);
+    _stat.inc();
+}
+
+inline void incServerStat(QHash<QByteArray, Targoman::Common::clsCountAndSpeed>& _stats, const QByteArray& _key){
+    QMutexLocker Locker(&gServerStatsLock);
+    _stats[_key].inc();
+}
 
 class clsAPIObject;
 
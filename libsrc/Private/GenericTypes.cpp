@@ -25,6 +25,8 @@
 #include "GenericTypes.h"
 #include "HTTPExceptions.h"
 #include "Private/Configs.hpp"
+#include "Private/clsJSONEngine.h"
+#include "Private/clsPercentDecoder.h"
 #include "QFieldValidator.h"
 
 namespace QHttp {
@@ -96,12 +98,11 @@ void registerGenericTypes()
                        _value.canConvert<double>())
                         return QJsonDocument::fromVariant(_value);
 
-                    QJsonParseError Error;
-                    QJsonDocument Doc;
-                    Doc = Doc.fromJson(_value.toString().toUtf8(), &Error);
+                    QString Error;
+                    QJsonDocument Doc = clsJSONEngine::parse(_value.toString().toUtf8(), &Error);
 
-                    if(Error.error != QJsonParseError::NoError)
-                        throw exHTTPBadRequest(_paramName + " is not a valid Json: <"+_value.toString()+">" + Error.errorString());
+                    if(Doc.isNull())
+                        throw exHTTPBadRequest(_paramName + " is not a valid Json: <"+_value.toString()+">" + Error);
                     return  Doc;
                 }
     );
@@ -127,13 +128,25 @@ void registerGenericTypes()
                 [](const QHttp::ExtraPath_t& _value) -> QVariant {return _value;},
                 [](const QVariant& _value, const QByteArray&) -> QHttp::ExtraPath_t {
                     QHttp::ExtraPath_t Value;
-                    QUrl URL = QUrl::fromPercentEncoding(("http://127.0.0.1/" + _value.toString()).toUtf8());
-                    Value=URL.path().remove(0,1);
-
+                    Value = clsPercentDecoder::decodeToString(_value.toString(), false);
                     return  Value;
                 }
     );
 
+    QHTTP_REGISTER_METATYPE(
+                COMPLEXITY_Complex,
+                QHttp::AsyncResponse_t,
+                nullptr,
+                [](const QVariant& _value, const QByteArray&) -> QHttp::AsyncResponse_t {return _value.value<QHttp::AsyncResponse_t>();}
+    );
+
+    QHTTP_REGISTER_METATYPE(
+                COMPLEXITY_Complex,
+                QHttp::BodyStream_t,
+                nullptr,
+                [](const QVariant& _value, const QByteArray&) -> QHttp::BodyStream_t {return _value.value<QHttp::BodyStream_t>();}
+    );
+
     QHTTP_VALIDATION_REQUIRED_TYPE_IMPL(COMPLEXITY_String, QHttp::MD5_t, optional(QFV.md5()), _value);
     QHTTP_VALIDATION_REQUIRED_TYPE_IMPL(COMPLEXITY_String, QHttp::Email_t, optional(QFV.email()), _value);
     QHTTP_VALIDATION_REQUIRED_TYPE_IMPL(COMPLEXITY_String, QHttp::Mobile_t, optional(QFV.mobile()), _value);
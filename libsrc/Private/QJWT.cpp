@@ -25,6 +25,7 @@
 #include "QJWT.h"
 #include "Configs.hpp"
 #include "clsSimpleCrypt.h"
+#include "clsJSONEngine.h"
 
 namespace QHttp {
 namespace Private{
@@ -70,10 +71,10 @@ QJsonObject QJWT::verifyReturnPayload(const QString& _jwt)
         throw exHTTPForbidden("Invalid JWT Token");
     if(QJWT::hash((JWTParts.at(0) + "." + JWTParts.at(1)).toUtf8()).toBase64() != JWTParts[2])
         throw exHTTPForbidden("JWT signature verification failed");
-    QJsonParseError Error;
-    QJsonDocument Payload = QJsonDocument::fromJson(QByteArray::fromBase64(JWTParts.at(1).toLatin1()), &Error);
+    QString Error;
+    QJsonDocument Payload = clsJSONEngine::parse(QByteArray::fromBase64(JWTParts.at(1).toLatin1()), &Error);
     if(Payload.isNull())
-        throw exHTTPForbidden("Invalid JWT payload: " + Error.errorString());
+        throw exHTTPForbidden("Invalid JWT payload: " + Error);
 
     QJsonObject JWTPayload = Payload.object();
     if(JWTPayload.empty())
@@ -87,9 +88,9 @@ QJsonObject QJWT::verifyReturnPayload(const QString& _jwt)
         if(Decrypted.isEmpty())
             throw exHTTPExpectationFailed(QString("Invalid empty private JWT payload: DEC ErrNo: %1").arg(simpleCryptInstance()->lastError()));
 
-        QJsonDocument Private = QJsonDocument::fromJson(Decrypted.toUtf8(), &Error);
+        QJsonDocument Private = clsJSONEngine::parse(Decrypted.toUtf8(), &Error);
         if(Private.isNull())
-            throw exHTTPExpectationFailed("Invalid private JWT payload: " + Error.errorString());
+            throw exHTTPExpectationFailed("Invalid private JWT payload: " + Error);
 
         JWTPayload["prv"] = Private.object();
     }
@@ -96,6 +96,9 @@ void RESTAPIRegistry::registerRESTAPI(intfRESTAPIHolder* _module, const QMetaMet
             gOrderedMetaTypeInfo.append(MetaTypeInfoMapIter.value());
         }
     }
+    if(gConfigs.Private.IsStarted)
+        throw exRESTRegistry("APIs can not be registered while server is started");
+
     if ((_method.name().startsWith("api") == false &&
          _method.name().startsWith("asyncApi") == false)||
         _method.typeName() == nullptr)
@@ -134,6 +137,24 @@ void RESTAPIRegistry::registerRESTAPI(intfRESTAPIHolder* _module, const QMetaMet
         if(!Found)
             throw exRESTRegistry("Seems that you have not use API macro to define your API");
 
+        intfAPIInvoker* Invoker = nullptr;
+        for (int i=0; i<_module->metaObject()->methodCount(); ++i)
+            if(_module->metaObject()->method(i).name() == "invokerOf" + MethodName){
+                _module->metaObject()->method(i).invoke(_module,
+                                                        Qt::DirectConnection,
+                                                        Q_RETURN_ARG(QHttp::intfAPIInvoker*, Invoker)
+                                                        );
+                break;
+            }
+        if(Invoker && Invoker->paramsCount() != _method.parameterCount()){
+            /* Cloned methods generated by moc for default arguments share the invoker of the full method */
+            delete Invoker;
+            Invoker = nullptr;
+        }
+        /* APIs are invoked just through their typed invoker. Clones are registered on the API object of the full method */
+        if(Invoker == nullptr && (_method.attributes() & QMetaMethod::Cloned) == 0)
+            throw exRESTRegistry("Seems that you have not use API macro to define your API");
+
 
         auto makeMethodName = [MethodName](int _start) -> QString{
             if(MethodName.size() >= _start)
@@ -199,7 +220,7 @@ void RESTAPIRegistry::registerRESTAPI(intfRESTAPIHolder* _module, const QMetaMet
             ParamIndex++;
         }
 
-        QMetaMethodExtended Method(_method, DefaultValues, MethodDoc);
+        QMetaMethodExtended Method(_method, DefaultValues, MethodDoc, QSharedPointer<intfAPIInvoker>(Invoker));
 
         if(MethodName.startsWith("GET"))
             RESTAPIRegistry::addRegistryEntry(RESTAPIRegistry::Registry, _module, Method, "GET", makeMethodName(sizeof("GET")));
@@ -217,6 +238,8 @@ void RESTAPIRegistry::registerRESTAPI(intfRESTAPIHolder* _module, const QMetaMet
             RESTAPIRegistry::addRegistryEntry(RESTAPIRegistry::Registry, _module, Method, "PATCH", makeMethodName(sizeof("UPDATE")));
         else if (MethodName.startsWith("WS")){
 #ifdef QHTTP_ENABLE_WEBSOCKET
+            if(RESTAPIRegistry::isAsyncMethod(_method))
+                throw exRESTRegistry("Async APIs are not supported on websockets");
             RESTAPIRegistry::addRegistryEntry(RESTAPIRegistry::WSRegistry, _module, Method, "WS", makeMethodName(sizeof("WS")));
 #else
             throw exRESTRegistry("Websockets are not enabled in this QRestServer please compile with websockets support");
@@ -234,7 +257,7 @@ void RESTAPIRegistry::registerRESTAPI(intfRESTAPIHolder* _module, const QMetaMet
 QMap<QString, QString> RESTAPIRegistry::extractMethods(QHash<QString, clsAPIObject*>& _registry, const QString& _module, bool _showTypes, bool _prettifyTypes)
 {
     static auto type2Str = [_prettifyTypes](int _typeID) {
-        if(_prettifyTypes == false || _typeID > 1023)
+        if(_prettifyTypes == false || _typeID > 1023 || gOrderedMetaTypeInfo.at(_typeID) == nullptr)
             return QString(QMetaType::typeName(_typeID));
 
         return gOrderedMetaTypeInfo.at(_typeID)->PrettyTypeName;
@@ -294,6 +317,8 @@ QMap<QString, QString> RESTAPIRegistry::extractMethods(QHash<QString, clsAPIObje
 }
 
 QJsonObject RESTAPIRegistry::retriveOpenAPIJson(){
+    static QMutex Lock;
+    QMutexLocker Locker(&Lock);
     if(RESTAPIRegistry::CachedOpenAPI.isEmpty() == false)
         return RESTAPIRegistry::CachedOpenAPI;
 
@@ -392,6 +417,8 @@ QJsonObject RESTAPIRegistry::retriveOpenAPIJson(){
                   || ParamType == PARAM_REMOTE_IP
                   || ParamType == PARAM_COOKIES
                   || ParamType == PARAM_JWT
+                  || ParamType == PARAM_ASYNC_RESPONSE
+                  || ParamType == PARAM_BODY_STREAM
                   )
                 return;
             QJsonObject ParamSpecs;
@@ -480,6 +507,8 @@ QJsonObject RESTAPIRegistry::retriveOpenAPIJson(){
                           || ParamType == PARAM_REMOTE_IP
                           || ParamType == PARAM_COOKIES
                           || ParamType == PARAM_JWT
+                          || ParamType == PARAM_ASYNC_RESPONSE
+                          || ParamType == PARAM_BODY_STREAM
                           )
                         continue;
 
@@ -530,7 +559,7 @@ QJsonObject RESTAPIRegistry::retriveOpenAPIJson(){
         };
 
         auto add2Paths = [PathString, HTTPMethod](QJsonObject& PathsObject, const QJsonObject& _currPathMethodInfo, QStringList* _extraPathsStorage){
-            QString Path = PathString + (_extraPathsStorage ? ("/{" + _extraPathsStorage->join("},{") + "}") : "");
+            QString Path = PathString + (_extraPathsStorage ? ("/{" + _extraPathsStorage->join("}/{") + "}") : "");
             if(PathsObject.contains(Path)){
                 QJsonObject CurrPathObject = PathsObject.value(Path).toObject();
                 CurrPathObject[HTTPMethod] = _currPathMethodInfo;
@@ -549,6 +578,8 @@ QJsonObject RESTAPIRegistry::retriveOpenAPIJson(){
                && ParamType != PARAM_COOKIES
                && ParamType != PARAM_JWT
                &&*/ ParamType != PARAM_EXTRAPATH
+               && ParamType != PARAM_ASYNC_RESPONSE
+               && ParamType != PARAM_BODY_STREAM
                ){
                 HasNonAutoParams = true;
                 break;
@@ -612,13 +643,24 @@ QString RESTAPIRegistry::isValidType(int _typeID, bool _validate4Input){
 }
 
 void RESTAPIRegistry::validateMethodInputAndOutput(const QMetaMethod& _method){
-    if(_method.parameterCount() > 10)
-        throw exRESTRegistry("Unable to register methods with more than 10 input args <"+_method.name()+">");
-
     QString ErrMessage;
-    if ((ErrMessage = RESTAPIRegistry::isValidType(_method.returnType(), false)).size())
+    if(_method.returnType() == QMetaType::Void){
+        if(_method.name().startsWith("async") == false)
+            throw exRESTRegistry("Only async APIs can return void <"+_method.name()+">");
+    }else if(strcmp(_method.typeName(), RETURN_TASK) == 0){
+#ifndef QHTTP_ENABLE_COROUTINES
+        throw exRESTRegistry("Coroutines are not enabled in this QRestServer please compile with coroutines support");
+#endif
+    }else if ((ErrMessage = RESTAPIRegistry::isValidType(_method.returnType(), false)).size())
         throw exRESTRegistry(QString("Invalid return type(%1): %2").arg(_method.typeName()).arg(ErrMessage));
 
+    /* Results of async APIs are discarded so they must respond through AsyncResponse_t. Coroutines respond by co_return */
+    if(_method.name().startsWith("async") &&
+       strcmp(_method.typeName(), RETURN_TASK) != 0 &&
+       (_method.attributes() & QMetaMethod::Cloned) == 0 &&
+       _method.parameterTypes().contains(PARAM_ASYNC_RESPONSE) == false)
+        throw exRESTRegistry("Async APIs must accept a " PARAM_ASYNC_RESPONSE " parameter <"+_method.name()+">");
+
     ErrMessage.clear();
 
     for(int i=0; i<_method.parameterCount(); ++i){
@@ -641,13 +683,15 @@ void RESTAPIRegistry::validateMethodInputAndOutput(const QMetaMethod& _method){
 
 constexpr char CACHE_INTERNAL[] = "CACHEABLE_";
 constexpr char CACHE_CENTRAL[]  = "CENTRALCACHE_";
+constexpr char MAX_BODY[]       = "MAXBODY_";
 
 void RESTAPIRegistry::addRegistryEntry(QHash<QString, QHttp::Private::clsAPIObject *>& _registry,
                                        intfRESTAPIHolder* _module,
                                        const QMetaMethodExtended& _method,
                                        const QString& _httpMethod,
                                        const QString& _methodName){
-    QString MethodKey = RESTAPIRegistry::makeRESTAPIKey(_httpMethod, "/" + _module->moduleBaseName().replace("::", "/")+ '/' + _methodName);
+    QString Path = "/" + _module->moduleBaseName().replace("::", "/")+ '/' + _methodName;
+    QString MethodKey = RESTAPIRegistry::makeRESTAPIKey(_httpMethod, Path);
 
     if(_registry.contains(MethodKey)){
         if(RESTAPIRegistry::Registry.value(MethodKey)->isPolymorphic(_method))
@@ -656,24 +700,55 @@ void RESTAPIRegistry::addRegistryEntry(QHash<QString, QHttp::Private::clsAPIObje
     }else{
         if(RESTAPIRegistry::getCacheSeconds(_method, CACHE_INTERNAL) > 0 && RESTAPIRegistry::getCacheSeconds(_method, CACHE_CENTRAL) >0)
             throw exRESTRegistry("Both internal and central cache can not be defined on an API");
+        if(RESTAPIRegistry::isAsyncMethod(_method) &&
+           (RESTAPIRegistry::getCacheSeconds(_method, CACHE_INTERNAL) != 0 || RESTAPIRegistry::getCacheSeconds(_method, CACHE_CENTRAL) != 0))
+            throw exRESTRegistry("Cache can not be defined on async APIs");
 
         _registry.insert(MethodKey,
                          new clsAPIObject(_module,
                                           _method,
-                                          QString(_method.name()).startsWith("async"),
+                                          RESTAPIRegistry::isAsyncMethod(_method),
                                           RESTAPIRegistry::getCacheSeconds(_method, CACHE_INTERNAL),
                                           RESTAPIRegistry::getCacheSeconds(_method, CACHE_CENTRAL),
+                                          RESTAPIRegistry::getMaxBodySize(_method),
                                           !_methodName.isEmpty()
                                           ));
+        clsAPIObject* APIObject = _registry.value(MethodKey);
+        RESTAPIRegistry::Routes.add(routeSlot(_httpMethod), Path, APIObject);
+
+        if(APIObject->requiresExtraPath()){
+            QMap<qint8, QString> PKs;
+            foreach(auto Item, _module->filterItems())
+                if(Item.PKIndex >= 0)
+                    PKs.insert(Item.PKIndex, Item.Name);
+            if(PKs.size()){
+                if(Path.endsWith('/'))
+                    Path.chop(1);
+                RESTAPIRegistry::Routes.add(routeSlot(_httpMethod), Path + "/{" + PKs.values().join("}/{") + "}", APIObject);
+            }
+        }
     }
 }
 
+void RESTAPIRegistry::compileRoutes()
+{
+    RESTAPIRegistry::Routes.compile([](const clsAPIObject* _apiObject, const QString& _paramName) {
+        return _apiObject->namedParamIndex(_paramName);
+    });
+}
+
+bool RESTAPIRegistry::isAsyncMethod(const QMetaMethod& _method){
+    return _method.name().startsWith("async") || strcmp(_method.typeName(), RETURN_TASK) == 0;
+}
+
+/* moc joins all tags of a method by space so each tag is checked separately */
 int RESTAPIRegistry::getCacheSeconds(const QMetaMethod& _method, const char* _type){
     if(_method.tag() == nullptr || _method.tag()[0] == '\0')
         return 0;
-    QString Tag = _method.tag();
-    if(Tag.startsWith(_type) && Tag.size () > 12){
-        Tag = Tag.mid(10);
+    foreach(QString Tag, QString(_method.tag()).split(' ', QString::SkipEmptyParts)){
+        if(Tag.startsWith(_type) == false || Tag.size() <= static_cast<int>(strlen(_type)) + 1)
+            continue;
+        Tag = Tag.mid(static_cast<int>(strlen(_type)));
         if(_type == CACHE_INTERNAL && Tag == "INF")
             return -1;
         char Type = Tag.rbegin()->toLatin1();
@@ -689,12 +764,35 @@ int RESTAPIRegistry::getCacheSeconds(const QMetaMethod& _method, const char* _ty
     return 0;
 }
 
+qint64 RESTAPIRegistry::getMaxBodySize(const QMetaMethod& _method){
+    if(_method.tag() == nullptr || _method.tag()[0] == '\0')
+        return 0;
+    foreach(QString Tag, QString(_method.tag()).split(' ', QString::SkipEmptyParts)){
+        if(Tag.startsWith(MAX_BODY) == false)
+            continue;
+        Tag = Tag.mid(sizeof(MAX_BODY) - 1);
+        bool Ok = false;
+        qint64 Number = Tag.mid(0, Tag.size() - 1).toLongLong(&Ok);
+        if(Ok && Number > 0)
+            switch(Tag.size() ? Tag.rbegin()->toLatin1() : '\0'){
+            case 'K': return Number << 10;
+            case 'M': return Number << 20;
+            case 'G': return Number << 30;
+            default: break;
+            }
+        throw exRESTRegistry("Invalid MAXBODY size or unit defined for api: " + _method.methodSignature());
+    }
+    return 0;
+}
+
 
 Cache_t InternalCache::Cache;
-QMutex InternalCache::Lock;
+QReadWriteLock InternalCache::Lock;
 
 QScopedPointer<intfCacheConnector> CentralCache::Connector;
+QMutex CentralCache::Lock;
 QHash<QString, clsAPIObject*>  RESTAPIRegistry::Registry;
+clsRouteTable                  RESTAPIRegistry::Routes;
 #ifdef QHTTP_ENABLE_WEBSOCKET
 QHash<QString, clsAPIObject*>  RESTAPIRegistry::WSRegistry;
 #endif
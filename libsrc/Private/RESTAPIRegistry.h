@@ -30,6 +30,7 @@
 
 #include "Private/Configs.hpp"
 #include "Private/clsAPIObject.hpp"
+#include "Private/clsRouteTable.h"
 #include "Private/NumericTypes.hpp"
 
 namespace QHttp {
@@ -45,16 +46,17 @@ public:
     }
 
     static inline clsAPIObject*
-    getAPIObject(const QString _httpMethod, const QString& _path){
-        return RESTAPIRegistry::Registry.value(RESTAPIRegistry::makeRESTAPIKey(_httpMethod, _path));
+    getAPIObject(qhttp::THttpMethod _httpMethod, const QString& _path, QString* _extraPath = nullptr, PathArgs_t* _pathArgs = nullptr){
+        return RESTAPIRegistry::Routes.find(routeSlot(_httpMethod), _path, _extraPath, _pathArgs);
     }
 #ifdef QHTTP_ENABLE_WEBSOCKET
-    static inline clsAPIObject* getWSAPIObject(const QString& _path){
-        return RESTAPIRegistry::WSRegistry.value(RESTAPIRegistry::makeRESTAPIKey("WS", _path));
+    static inline clsAPIObject* getWSAPIObject(const QString& _path, QString* _extraPath = nullptr, PathArgs_t* _pathArgs = nullptr){
+        return RESTAPIRegistry::Routes.find(ROUTE_WS, _path, _extraPath, _pathArgs);
     }
 #endif
 
     static void registerRESTAPI(intfRESTAPIHolder* _module, const QMetaMethod& _method);
+    static void compileRoutes();
     static QStringList registeredAPIs(const QString& _module, bool _showParams = false, bool _showTypes = false, bool _prettifyTypes = true);
     static QJsonObject retriveOpenAPIJson();
 
@@ -63,10 +65,13 @@ private:
     static void validateMethodInputAndOutput(const QMetaMethod& _method);
     static void addRegistryEntry(QHash<QString, clsAPIObject*>& _registry, intfRESTAPIHolder* _module, const QMetaMethodExtended& _method, const QString& _httpMethod, const QString& _methodName);
     static int  getCacheSeconds(const QMetaMethod& _method, const char* _type);
+    static qint64 getMaxBodySize(const QMetaMethod& _method);
+    static bool isAsyncMethod(const QMetaMethod& _method);
     static QMap<QString, QString> extractMethods(QHash<QString, clsAPIObject*>& _registry, const QString& _module, bool _showTypes, bool _prettifyTypes);
 
 private:
     static QHash<QString, clsAPIObject*>  Registry;
+    static clsRouteTable                  Routes;
     static QJsonObject CachedOpenAPI;
 
 #ifdef QHTTP_ENABLE_WEBSOCKET
@@ -187,7 +187,7 @@ const qhttp::TStatusCode StatusCodeOnMethod[] = {
 
 void RequestHandler::findAndCallAPI(const QString& _api, QHttpRequest *_req, QHttpResponse *_res)
 {
-    clsAPIObject* APIObject = RESTAPIRegistry::getAPIObject(_req->methodString(), _api);
+    clsAPIObject* APIObject = RESTAPIRegistry::getAPIObject(_req->method(), _api);
 
     if(!APIObject){
         gServerStats.Errors.inc();
@@ -197,7 +197,7 @@ void RequestHandler::findAndCallAPI(const QString& _api, QHttpRequest *_req, QHt
                                          true);
     }
 
-    QStringList Queries = _req->url().query().split('&', QString::SkipEmptyParts);
+    clsQueryArgs Queries(_req->url().query(QUrl::FullyEncoded).toLatin1());
     RequestHandler::sendResponse(_res, StatusCodeOnMethod[_req->method()], APIObject->invoke(Queries));
 
 }
@@ -31,6 +31,7 @@
 #include "libTargomanCommon/Logger.h"
 #include "Private/Configs.hpp"
 #include "Private/RESTAPIRegistry.h"
+#include "Private/clsJSONEngine.h"
 #include "QFieldValidator.h"
 
 namespace QHttp {
@@ -89,10 +90,10 @@ private slots:
             };
 
             try{
-                QJsonParseError Error;
-                QJsonDocument JSON = QJsonDocument::fromJson(_message.toUtf8(), &Error);
+                QString Error;
+                QJsonDocument JSON = clsJSONEngine::parse(_message.toUtf8(), &Error);
                 if(JSON.isNull())
-                    throw exHTTPBadRequest(QString("Invalid JSON request: %1").arg(Error.errorString()));
+                    throw exHTTPBadRequest(QString("Invalid JSON request: %1").arg(Error));
 
                 QString ExtraAPIPath;
                 QJsonObject JSONReqObject = JSON.object();
@@ -100,30 +101,23 @@ private slots:
                 if(API.isEmpty())
                     return sendError(qhttp::ESTATUS_BAD_REQUEST, "No API path specified");
 
-                clsAPIObject* APIObject = RESTAPIRegistry::getWSAPIObject (API);
-                if(!APIObject) {
-                    QString Path = API;
-                    if(Path.endsWith('/'))
-                        Path.truncate(Path.size() - 1);
-                    ExtraAPIPath = Path.mid(Path.lastIndexOf('/'));
-                    Path = Path.mid(0, Path.lastIndexOf('/'));
-                    APIObject = RESTAPIRegistry::getWSAPIObject(Path);
-                }
+                PathArgs_t PathArgs;
+                clsAPIObject* APIObject = RESTAPIRegistry::getWSAPIObject(API, &ExtraAPIPath, &PathArgs);
 
                 if(!APIObject)
                     return sendError(qhttp::ESTATUS_NOT_FOUND, "WS API not found ("+API+")");
 
                 QVariantMap APIArgs = JSONReqObject.begin().value().toObject().toVariantMap();
-                QStringList Queries;
+                clsQueryArgs Queries;
                 for(auto Map = APIArgs.begin(); Map != APIArgs.end(); ++Map)
-                    Queries.append(Map.key() + '=' + Map.value().toString());
+                    Queries.append(Map.key(), Map.value().toString());
 
                 /*if(ExtraAPIPath)
                     Queries.append(REQUES)*/
 
 
                 QByteArray Data = QJsonDocument(QJsonObject({{"result",
-                                                              QJsonValue::fromVariant(APIObject->invoke(Queries))
+                                                              QJsonValue::fromVariant(APIObject->invoke(Queries, {}, {}, {}, {}, {}, ExtraAPIPath, {}, PathArgs))
                                                              }})).toJson(gConfigs.Public.IndentedJson ? QJsonDocument::Indented : QJsonDocument::Compact);
                 pSocket->sendTextMessage(Data.data());
             }catch(Targoman::Common::exTargomanBase& ex){
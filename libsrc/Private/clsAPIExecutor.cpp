@@ -0,0 +1,168 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#include <chrono>
+#include "clsAPIExecutor.h"
+
+namespace QHttp {
+namespace Private {
+
+static inline qint64 nowMSecs(){
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+clsAPIExecutor::clsAPIExecutor(quint16 _workersCount)
+{
+    for(quint16 i = 0; i < _workersCount; ++i)
+        this->Queues.push_back(new stuWorkerQueue);
+    for(quint16 i = 0; i < _workersCount; ++i){
+        this->Workers.push_back(new clsWorker(this, i));
+        this->Workers.back()->start();
+    }
+}
+
+clsAPIExecutor::~clsAPIExecutor()
+{
+    this->waitForDone();
+    for(stuWorkerQueue* Queue : this->Queues)
+        delete Queue;
+}
+
+void clsAPIExecutor::start(const QByteArray& _module, QRunnable* _job)
+{
+    stuJob Job = {_job, _module, nowMSecs()};
+    stuWorkerQueue* HomeQueue = this->Queues.at(qHash(_module) % this->Queues.size());
+    this->updateStats(Job, true);
+    {
+        QMutexLocker Locker(&HomeQueue->Lock);
+        auto Lane = HomeQueue->Lanes.begin();
+        for(; Lane != HomeQueue->Lanes.end(); ++Lane)
+            if(Lane->Module == _module)
+                break;
+        if(Lane == HomeQueue->Lanes.end()){
+            HomeQueue->Lanes.push_back(stuLane{_module, {}});
+            Lane = HomeQueue->Lanes.end() - 1;
+        }
+        Lane->Jobs.push_back(Job);
+    }
+
+    this->PendingJobs.fetchAndAddOrdered(1);
+    QMutexLocker Locker(&this->IdleLock);
+    this->HasJob.wakeOne();
+}
+
+void clsAPIExecutor::waitForDone()
+{
+    {
+        QMutexLocker Locker(&this->IdleLock);
+        this->Stopping = true;
+        this->HasJob.wakeAll();
+    }
+    for(clsWorker* Worker : this->Workers){
+        Worker->wait();
+        delete Worker;
+    }
+    this->Workers.clear();
+}
+
+QHash<QByteArray, stuQueueStatistics> clsAPIExecutor::queueStats()
+{
+    QMutexLocker Locker(&this->StatsLock);
+    return this->Stats;
+}
+
+void clsAPIExecutor::workerLoop(quint16 _index)
+{
+    stuJob Job;
+    forever{
+        if(this->popLocal(_index, Job) || this->steal(_index, Job)){
+            this->PendingJobs.fetchAndSubOrdered(1);
+            this->updateStats(Job, false);
+            Job.Runnable->run();
+            if(Job.Runnable->autoDelete())
+                delete Job.Runnable;
+            continue;
+        }
+
+        QMutexLocker Locker(&this->IdleLock);
+        if(this->PendingJobs.load() > 0)
+            continue;
+        if(this->Stopping)
+            return;
+        this->HasJob.wait(&this->IdleLock, 100);
+    }
+}
+
+bool clsAPIExecutor::popLocal(quint16 _index, stuJob& _job)
+{
+    stuWorkerQueue* Queue = this->Queues.at(_index);
+    QMutexLocker Locker(&Queue->Lock);
+    for(size_t i = 0; i < Queue->Lanes.size(); ++i){
+        stuLane& Lane = Queue->Lanes.at((Queue->NextLane + i) % Queue->Lanes.size());
+        if(Lane.Jobs.empty())
+            continue;
+        _job = Lane.Jobs.front();
+        Lane.Jobs.pop_front();
+        Queue->NextLane = (Queue->NextLane + i + 1) % Queue->Lanes.size();
+        return true;
+    }
+    return false;
+}
+
+bool clsAPIExecutor::steal(quint16 _thiefIndex, stuJob& _job)
+{
+    for(size_t i = 1; i < this->Queues.size(); ++i){
+        stuWorkerQueue* Victim = this->Queues.at((_thiefIndex + i) % this->Queues.size());
+        QMutexLocker Locker(&Victim->Lock);
+        stuLane* BusiestLane = nullptr;
+        for(stuLane& Lane : Victim->Lanes)
+            if(Lane.Jobs.size() && (BusiestLane == nullptr || Lane.Jobs.size() > BusiestLane->Jobs.size()))
+                BusiestLane = &Lane;
+        if(BusiestLane == nullptr)
+            continue;
+        /* Oldest job is stolen so requests of a hot module are served in order and not shed by MaxQueueTimeMSecs */
+        _job = BusiestLane->Jobs.front();
+        BusiestLane->Jobs.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void clsAPIExecutor::updateStats(const stuJob& _job, bool _enqueued)
+{
+    QMutexLocker Locker(&this->StatsLock);
+    stuQueueStatistics& ModuleStats = this->Stats[_job.Module];
+    if(_enqueued){
+        ++ModuleStats.Depth;
+        return;
+    }
+
+    quint64 WaitMSecs = static_cast<quint64>(nowMSecs() - _job.EnqueuedAt);
+    --ModuleStats.Depth;
+    ++ModuleStats.Dequeued;
+    ModuleStats.TotalWaitMSecs += WaitMSecs;
+    ModuleStats.MaxWaitMSecs = qMax(ModuleStats.MaxWaitMSecs, WaitMSecs);
+}
+
+}
+}
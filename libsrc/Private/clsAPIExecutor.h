@@ -0,0 +1,105 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#ifndef QHTTP_PRIVATE_CLSAPIEXECUTOR_H
+#define QHTTP_PRIVATE_CLSAPIEXECUTOR_H
+
+#include <deque>
+#include <vector>
+#include <QThread>
+#include <QRunnable>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include "QHttp/GenericTypes.h"
+
+namespace QHttp {
+namespace Private {
+
+/**
+ * @brief The clsAPIExecutor class is a work-stealing executor used to invoke APIs. Each worker owns a queue which is divided
+ *        into per-module lanes served round-robin so a busy module can not starve others. Jobs are queued on the home worker
+ *        of their module and idle workers steal from the busiest lane of other workers.
+ */
+class clsAPIExecutor
+{
+public:
+    clsAPIExecutor(quint16 _workersCount);
+    ~clsAPIExecutor();
+
+    void start(const QByteArray& _module, QRunnable* _job);
+    void waitForDone();
+    QHash<QByteArray, stuQueueStatistics> queueStats();
+
+private:
+    struct stuJob{
+        QRunnable*  Runnable;
+        QByteArray  Module;
+        qint64      EnqueuedAt;
+    };
+
+    struct stuLane{
+        QByteArray          Module;
+        std::deque<stuJob>  Jobs;
+    };
+
+    struct stuWorkerQueue{
+        QMutex                Lock;
+        std::vector<stuLane>  Lanes;
+        size_t                NextLane = 0;
+    };
+
+    class clsWorker : public QThread{
+    public:
+        clsWorker(clsAPIExecutor* _executor, quint16 _index) :
+            Executor(_executor),
+            Index(_index)
+        {}
+    private:
+        void run() Q_DECL_FINAL { this->Executor->workerLoop(this->Index); }
+    private:
+        clsAPIExecutor* Executor;
+        quint16         Index;
+    };
+
+private:
+    void workerLoop(quint16 _index);
+    bool popLocal(quint16 _index, stuJob& _job);
+    bool steal(quint16 _thiefIndex, stuJob& _job);
+    void updateStats(const stuJob& _job, bool _enqueued);
+
+private:
+    std::vector<stuWorkerQueue*>          Queues;
+    std::vector<clsWorker*>               Workers;
+    QAtomicInt                            PendingJobs;
+    bool                                  Stopping = false;
+    QMutex                                IdleLock;
+    QWaitCondition                        HasJob;
+    QMutex                                StatsLock;
+    QHash<QByteArray, stuQueueStatistics> Stats;
+};
+
+}
+}
+
+#endif // QHTTP_PRIVATE_CLSAPIEXECUTOR_H
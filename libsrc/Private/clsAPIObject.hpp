@@ -24,13 +24,25 @@
 #ifndef QHTTP_PRIVATE_CLSAPIOBJECT_HPP
 #define QHTTP_PRIVATE_CLSAPIOBJECT_HPP
 
-#include <QGenericArgument>
 #include <QMetaMethod>
+#include <QVector>
+#include <QVarLengthArray>
+#include <QSharedPointer>
+#include <QScopedArrayPointer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <algorithm>
+#include <cstddef>
 
 #include "QHttp/intfRESTAPIHolder.h"
+#include "QHttp/Task.hpp"
 
 #include "Private/Configs.hpp"
 #include "Private/RESTAPIRegistry.h"
+#include "Private/clsRouteTable.h"
+#include "Private/clsQueryArgs.h"
+#include "Private/clsJSONEngine.h"
+#include "Private/clsPercentDecoder.h"
 #include "Private/APICache.hpp"
 
 namespace QHttp {
@@ -42,31 +54,46 @@ namespace Private {
 #define PARAM_HEADERS   "QHttp::HEADERS_t"
 #define PARAM_EXTRAPATH "QHttp::ExtraPath_t"
 #define PARAM_DIRECTFILTER "QHttp::DirectFilters_t"
+#define PARAM_ASYNC_RESPONSE "QHttp::AsyncResponse_t"
+#define PARAM_BODY_STREAM "QHttp::BodyStream_t"
+#define RETURN_TASK "QHttp::Task"
+
+/// Arguments of APIs whose parameters need more storage than this are constructed on heap
+#define QHTTP_INLINE_ARGS_STORAGE_SIZE 512
+
+#ifdef QHTTP_ENABLE_COROUTINES
+extern void startAPITask(QHttp::Task&& _task, const QHttp::AsyncResponse_t& _asyncResponse);
+#endif
 
 class QMetaMethodExtended : public QMetaMethod {
 public:
-    QMetaMethodExtended(QMetaMethod _metaMethod, QVariantList _defaultValues, QString _doc):
+    QMetaMethodExtended(QMetaMethod _metaMethod, QVariantList _defaultValues, QString _doc, QSharedPointer<intfAPIInvoker> _invoker = {}):
         QMetaMethod(_metaMethod),
         Doc(_doc),
-        DefaultValues(_defaultValues)
+        DefaultValues(_defaultValues),
+        Invoker(_invoker)
     {}
 
     QString Doc;
     QVariantList DefaultValues;
+    QSharedPointer<intfAPIInvoker> Invoker;
 };
 
 class clsAPIObject : public intfAPIObject, public QObject
 {
 public:
-    clsAPIObject(intfRESTAPIHolder* _module, QMetaMethodExtended _method, bool _async, qint32 _cache4Internal, qint32 _cache4Central, bool _hasExtraMethodName) :
+    clsAPIObject(intfRESTAPIHolder* _module, QMetaMethodExtended _method, bool _async, qint32 _cache4Internal, qint32 _cache4Central, qint64 _maxBodySize, bool _hasExtraMethodName) :
         QObject(_module),
         BaseMethod(_method),
         IsAsync(_async),
         Cache4Secs(_cache4Internal),
         Cache4SecsCentral(_cache4Central),
+        MaxBodySize(_maxBodySize),
+        IsCoroutine(strcmp(_method.typeName(), RETURN_TASK) == 0),
         RequiredParamsCount(static_cast<quint8>(_method.parameterCount())),
         HasExtraMethodName(_hasExtraMethodName),
-        Parent(_module)
+        Parent(_module),
+        ModuleName(_module->moduleBaseName().toLatin1())
     {
         quint8 i = 0;
         foreach(const QByteArray& ParamName, _method.parameterNames()){
@@ -74,35 +101,66 @@ public:
             this->ParamTypes.append(QMetaType::typeName(_method.parameterType(i)));
             ++i;
         }
+        this->compileBindings();
     }
     ~clsAPIObject();
 
-    inline QString makeCacheKey(const QVariantList& _args) const{
-        return (this->BaseMethod.name() + QJsonValue::fromVariant(_args).toString().toUtf8()).constData();
+    inline QString makeCacheKey(const QVector<QJsonValue>& _values, int _count) const{
+        QJsonArray Values;
+        for(int i = 0; i < _count; ++i)
+            Values.append(_values.at(i));
+        return QString::fromUtf8(this->BaseMethod.name() + QJsonDocument(Values).toJson(QJsonDocument::Compact));
     }
 
     inline bool requiresJWT() const {
-        return this->ParamTypes.contains(PARAM_JWT);
+        return this->hasSource(PARAM_SOURCE_JWT);
     }
 
     inline bool requiresCookies() const {
-        return this->ParamTypes.contains(PARAM_COOKIES);
+        return this->hasSource(PARAM_SOURCE_Cookies);
     }
 
     inline bool requiresRemoteIP() const {
-        return this->ParamTypes.contains(PARAM_REMOTE_IP);
+        return this->hasSource(PARAM_SOURCE_RemoteIP);
     }
 
     inline bool requiresExtraPath() const {
-        return this->ParamTypes.contains(PARAM_EXTRAPATH);
+        return this->hasSource(PARAM_SOURCE_ExtraPath);
     }
 
     inline bool requiresHeaders() const {
-        return this->ParamTypes.contains(PARAM_HEADERS);
+        return this->hasSource(PARAM_SOURCE_Headers);
     }
 
     inline bool requiresDirectFilters() const {
-        return this->ParamTypes.contains(PARAM_DIRECTFILTER);
+        return this->hasSource(PARAM_SOURCE_DirectFilters);
+    }
+
+    inline bool requiresBodyStream() const {
+        return this->hasSource(PARAM_SOURCE_BodyStream);
+    }
+
+    /**
+     * @brief maxBodySize returns max request body size declared by MAXBODY_* tag of the API or zero when not specified
+     */
+    inline qint64 maxBodySize() const {
+        return this->MaxBodySize;
+    }
+
+    inline bool isAsync() const {
+        return this->IsAsync;
+    }
+
+    inline const QByteArray& moduleName() const {
+        return this->ModuleName;
+    }
+
+    inline quint32 acquireSlot() const {
+        return static_cast<quint32>(this->InFlight.fetchAndAddOrdered(1));
+    }
+
+    inline void releaseSlot() const {
+        this->InFlight.fetchAndSubOrdered(1);
     }
 
     inline QString paramType(quint8 _paramIndex) const {
@@ -125,148 +183,162 @@ public:
         return this->BaseMethod.DefaultValues.at(_paramIndex);
     }
 
-    inline QVariant invoke(const QStringList& _args,
-                           QList<QPair<QString, QString>> _bodyArgs = {},
+    /**
+     * @brief namedParamIndex returns index of the named parameter used to bind path template captures or -1 if not found
+     */
+    inline qint8 namedParamIndex(const QString& _name) const {
+        for(quint8 i = 0; i < this->Bindings.size(); ++i)
+            if(this->Bindings.at(i).Source == PARAM_SOURCE_Named && this->Bindings.at(i).Name == _name)
+                return static_cast<qint8>(i);
+        return -1;
+    }
+
+    inline QVariant invoke(const clsQueryArgs& _args,
+                           const clsQueryArgs& _bodyArgs = {},
                            qhttp::THeaderHash _headers = {},
                            qhttp::THeaderHash _cookies = {},
                            QJsonObject _jwt = {},
                            QString _remoteIP = {},
-                           QString _extraAPIPath = {}
+                           QString _extraAPIPath = {},
+                           QHttp::AsyncResponse_t _asyncResponse = {},
+                           const PathArgs_t& _pathArgs = {},
+                           const QJsonObject& _jsonBody = {},
+                           const QHttp::BodyStream_t& _bodyStream = {}
                            ) const{
         Q_ASSERT_X(this->parent(), "parent module", "Parent module not found to invoke method");
+        Q_ASSERT_X(this->BaseMethod.Invoker, "invoker", "APIs must be registered with their typed invoker");
 
-        int ExtraArgCount = 0;
-        if(this->ParamTypes.contains(PARAM_COOKIES))
-            ExtraArgCount++;
-        if(this->ParamTypes.contains(PARAM_HEADERS))
-            ExtraArgCount++;
-        if(this->ParamTypes.contains(PARAM_JWT))
-            ExtraArgCount++;
-        if(this->ParamTypes.contains(PARAM_REMOTE_IP))
-            ExtraArgCount++;
-        if(this->ParamTypes.contains(PARAM_EXTRAPATH))
-            ExtraArgCount++;
-        if(this->ParamTypes.contains(PARAM_DIRECTFILTER))
-            ExtraArgCount++;
-
-        if(_args.size() + _bodyArgs.size() + ExtraArgCount < this->RequiredParamsCount)
+        if(_args.size() + _bodyArgs.size() + _jsonBody.size() + _pathArgs.size() + this->ImplicitParamsCount < this->RequiredParamsCount)
             throw exHTTPBadRequest("Not enough arguments");
 
-        QVariantList Arguments;
+        /* Path captures are already bound to parameter indexes by the route table */
+        QVarLengthArray<const QString*, 16> PathValues(this->Bindings.size());
+        std::fill(PathValues.begin(), PathValues.end(), nullptr);
+        for(const stuPathArg& PathArg : _pathArgs)
+            if(PathArg.ParamIndex < PathValues.size())
+                PathValues[PathArg.ParamIndex] = &PathArg.Value;
+
+        /* Cache key is made of the values as received so it is built just for cacheable APIs */
+        const bool Cacheable = this->Cache4Secs != 0 || this->Cache4SecsCentral != 0;
+        QVector<QJsonValue> CacheValues(Cacheable ? this->Bindings.size() : 0);
 
-        qint8 FirstArgumentWithValue = -1;
+        stuArguments Arguments(this);
         qint8 LastArgumentWithValue = -1;
 
-        for(quint8 i=0; i< this->ParamNames.count(); ++i ){
-            bool ParamNotFound = true;
-            QVariant ArgumentValue;
-
-            static auto parseArgValue = [ArgumentValue](const QString& _paramName, const QString& _value) -> QVariant {
-                if((_value.startsWith('[') && _value.endsWith(']')) ||
-                   (_value.startsWith('{') && _value.endsWith('}'))){
-                    QJsonParseError Error;
-                    QJsonDocument JSON = QJsonDocument::fromJson(_value.toUtf8(), &Error);
-                    if(JSON.isNull())
-                        throw exHTTPBadRequest(QString("Invalid value for %1: %2").arg(_paramName).arg(Error.errorString()));
-                    return JSON.toVariant();
-                }else{
-                    return _value;
+        for(quint8 i=0; i< this->Bindings.size(); ++i ){
+            const stuParamBinding& Binding = this->Bindings.at(i);
+            void* Arg = Arguments.storage(i);
+            QJsonValue RawValue;
+
+            switch(Binding.Source){
+            case PARAM_SOURCE_Cookies:
+                new (Arg) QHttp::COOKIES_t(_cookies);
+                if(Cacheable) RawValue = QJsonValue::fromVariant(_cookies.toVariant());
+                break;
+            case PARAM_SOURCE_Headers:
+                new (Arg) QHttp::HEADERS_t(_headers);
+                if(Cacheable) RawValue = QJsonValue::fromVariant(_headers.toVariant());
+                break;
+            case PARAM_SOURCE_JWT:
+                new (Arg) QHttp::JWT_t(_jwt);
+                RawValue = _jwt;
+                break;
+            case PARAM_SOURCE_RemoteIP:
+                new (Arg) QHttp::RemoteIP_t(_remoteIP);
+                RawValue = _remoteIP;
+                break;
+            case PARAM_SOURCE_ExtraPath:
+                new (Arg) QHttp::ExtraPath_t(_extraAPIPath);
+                RawValue = _extraAPIPath;
+                break;
+            case PARAM_SOURCE_AsyncResponse:
+                new (Arg) QHttp::AsyncResponse_t(_asyncResponse);
+                break;
+            case PARAM_SOURCE_BodyStream:
+                new (Arg) QHttp::BodyStream_t(_bodyStream);
+                break;
+            case PARAM_SOURCE_DirectFilters:{
+                QHttp::DirectFilters_t DirectFilters;
+                for(int ArgIndex = 0; ArgIndex < _args.size(); ++ArgIndex){
+                    QString Name = _args.name(ArgIndex);
+                    QString Value = _args.value(ArgIndex);
+                    DirectFilters.insert(Name, clsAPIObject::isJSONValue(Value) ? clsAPIObject::parseJSONValue(Name, Value) : QVariant(Value));
                 }
-            };
-
-            if(this->ParamTypes.at(i) == PARAM_COOKIES){
-                ParamNotFound = false;
-                ArgumentValue = _cookies.toVariant();
+                if(Cacheable) RawValue = QJsonObject::fromVariantMap(DirectFilters);
+                new (Arg) QHttp::DirectFilters_t(DirectFilters);
+                break;
             }
+            case PARAM_SOURCE_Named:{
+                if(PathValues[i]){
+                    QString Value = clsPercentDecoder::decodeToString(*PathValues[i], false);
+                    this->bindString(Binding, Value, Arg);
+                    RawValue = Value;
+                    break;
+                }
 
-            if(ParamNotFound && this->ParamTypes.at(i) == PARAM_HEADERS){
-                ParamNotFound = false;
-                ArgumentValue = _headers.toVariant();
-            }
-
-            if(ParamNotFound && this->ParamTypes.at(i) == PARAM_JWT){
-                ParamNotFound = false;
-                ArgumentValue = _jwt;
-            }
-
-            if(ParamNotFound && this->ParamTypes.at(i) == PARAM_REMOTE_IP){
-                ParamNotFound = false;
-                ArgumentValue = _remoteIP;
-            }
-
-            if(ParamNotFound && this->ParamTypes.at(i) == PARAM_EXTRAPATH){
-                ParamNotFound = false;
-                ArgumentValue = _extraAPIPath;
-            }
-
-            if(ParamNotFound && this->ParamTypes.at(i) == PARAM_DIRECTFILTER){
-                ParamNotFound = false;
-                QHttp::DirectFilters_t DirectFilters;
-                foreach (const QString& Arg, _args)
-                    DirectFilters.insert(Arg.mid(0,Arg.indexOf('=')), parseArgValue(Arg.mid(0,Arg.indexOf('=')), QUrl::fromPercentEncoding(Arg.mid(Arg.indexOf('=') + 1).toUtf8())));
-
-                ArgumentValue = DirectFilters;
-            }
+                int ArgIndex = _args.indexOf(Binding.NameBytes, Binding.NameHash);
+                if(ArgIndex >= 0){
+                    QString Value = _args.value(ArgIndex);
+                    this->bindString(Binding, Value, Arg);
+                    RawValue = Value;
+                    break;
+                }
 
-            if(ParamNotFound)
-                foreach (const QString& Arg, _args){
-                    if(Arg.startsWith(this->ParamNames.at(i)+ '=')){
-                        ParamNotFound = false;
-                        ArgumentValue = parseArgValue(this->ParamNames.at(i), QUrl::fromPercentEncoding(Arg.mid(Arg.indexOf('=') + 1).toUtf8()));
+                if(_jsonBody.size()){
+                    auto JSONIter = _jsonBody.constFind(Binding.Name);
+                    if(JSONIter == _jsonBody.constEnd())
+                        JSONIter = _jsonBody.constFind(Binding.IndexName);
+                    if(JSONIter != _jsonBody.constEnd()){
+                        this->bindJSON(Binding, JSONIter.value(), Arg);
+                        RawValue = JSONIter.value();
                         break;
                     }
                 }
 
-            if(ParamNotFound)
-                foreach (auto BodyArg, _bodyArgs) {
-                    bool ConversionResult = true;
-                    if(BodyArg.first == this->ParamNames.at(i) || (BodyArg.first.toInt(&ConversionResult) == i && ConversionResult)){
-                        ParamNotFound = false;
-                        ArgumentValue = parseArgValue(this->ParamNames.at(i), BodyArg.second);
+                if(_bodyArgs.size()){
+                    ArgIndex = _bodyArgs.indexOf(Binding.NameBytes, Binding.NameHash);
+                    if(ArgIndex < 0)
+                        ArgIndex = _bodyArgs.indexOf(Binding.IndexNameBytes, Binding.IndexNameHash);
+                    if(ArgIndex >= 0){
+                        QString Value = _bodyArgs.value(ArgIndex);
+                        this->bindString(Binding, Value, Arg);
+                        RawValue = Value;
                         break;
                     }
                 }
 
-            if(ParamNotFound){
                 if(i < this->RequiredParamsCount)
                     throw exHTTPBadRequest(QString("Required parameter <%1> not specified").arg(this->ParamNames.at(i).constData()));
-                else
-                    Arguments.append(this->defaultValue(i));
+                /* Optional params are left to be filled with default value if a latter param has value */
                 continue;
-            }else if(ArgumentValue.isValid() == false)
-                throw exHTTPBadRequest(QString("Invalid value for %1: no conversion to QVariant defined").arg(this->ParamNames.at(i).constData()));
+            }
+            }
 
-            if(FirstArgumentWithValue < 0)
-                FirstArgumentWithValue = static_cast<qint8>(i);
+            Arguments.constructed(i);
+            if(Cacheable)
+                CacheValues[i] = RawValue;
             LastArgumentWithValue = static_cast<qint8>(i);
-
-            if(this->BaseMethod.parameterType(i) >= QHTTP_BASE_USER_DEFINED_TYPEID){
-                Q_ASSERT(this->BaseMethod.parameterType(i) - QHTTP_BASE_USER_DEFINED_TYPEID < gOrderedMetaTypeInfo.size());
-                Q_ASSERT(gUserDefinedTypesInfo.at(this->BaseMethod.parameterType(i) - QHTTP_BASE_USER_DEFINED_TYPEID) != nullptr);
-
-                Arguments.push_back(ArgumentValue);
-            }else{
-                Q_ASSERT(this->BaseMethod.parameterType(i) < gOrderedMetaTypeInfo.size());
-                Q_ASSERT(gOrderedMetaTypeInfo.at(this->BaseMethod.parameterType(i)) != nullptr);
-
-                Arguments.push_back(ArgumentValue);
-            }
         }
 
-        if(FirstArgumentWithValue < 0)
-            Arguments.clear();
-        else if (LastArgumentWithValue < Arguments.size() - 1)
-            Arguments = Arguments.mid(0, LastArgumentWithValue + 1);
+        /* Omitted trailing params get their C++ default values from the invoker so just the gaps are filled */
+        int ArgumentsCount = LastArgumentWithValue + 1;
+        for(quint8 i = 0; i < ArgumentsCount; ++i)
+            if(Arguments.isConstructed(i) == false){
+                this->Bindings.at(i).ArgManipulator->constructArgument(this->defaultValue(i), this->ParamNames.at(i), Arguments.storage(i));
+                Arguments.constructed(i);
+                if(Cacheable)
+                    CacheValues[i] = QJsonValue::fromVariant(this->defaultValue(i));
+            }
 
         QVariant Result;
         QString  CacheKey;
-        if(this->Cache4Secs != 0 || this->Cache4SecsCentral != 0)
-            CacheKey = this->makeCacheKey(Arguments);
+        if(Cacheable)
+            CacheKey = this->makeCacheKey(CacheValues, ArgumentsCount);
 
         if(this->Cache4Secs != 0){
             QVariant CachedValue =  InternalCache::storedValue(CacheKey);
             if(CachedValue.isValid()){
-                gServerStats.APIInternalCacheStats[this->BaseMethod.name()].inc();
+                incServerStat(gServerStats.APIInternalCacheStats, this->BaseMethod.name());
                 return CachedValue;
             }
         }
@@ -274,21 +346,35 @@ public:
         if(this->Cache4SecsCentral){
             QVariant CachedValue =  CentralCache::storedValue(CacheKey);
             if(CachedValue.isValid()){
-                gServerStats.APICentralCacheStats[this->BaseMethod.name()].inc();
+                incServerStat(gServerStats.APICentralCacheStats, this->BaseMethod.name());
                 return CachedValue;
             }
         }
 
-        if(this->BaseMethod.returnType() >= QHTTP_BASE_USER_DEFINED_TYPEID){
-            Q_ASSERT(this->BaseMethod.returnType() - QHTTP_BASE_USER_DEFINED_TYPEID < gOrderedMetaTypeInfo.size());
+        /* Missing required params are rejected before invocation so invoker must not fail */
+        if(this->BaseMethod.returnType() == QMetaType::Void){
+            Q_ASSERT_X(this->IsAsync, "invoke", "Only async APIs can return void");
+            if(this->BaseMethod.Invoker->invoke(Arguments.Pointers.constData(), ArgumentsCount, nullptr) == false)
+                throw exHTTPInternalServerError(QString("Unable to invoke method"));
+#ifdef QHTTP_ENABLE_COROUTINES
+        }else if(this->IsCoroutine){
+            QHttp::Task APITask;
+            if(this->BaseMethod.Invoker->invoke(Arguments.Pointers.constData(), ArgumentsCount, &APITask) == false)
+                throw exHTTPInternalServerError(QString("Unable to invoke method"));
+            startAPITask(std::move(APITask), _asyncResponse);
+#endif
+        }else if(this->BaseMethod.returnType() >= QHTTP_BASE_USER_DEFINED_TYPEID){
+            Q_ASSERT(this->BaseMethod.returnType() - QHTTP_BASE_USER_DEFINED_TYPEID < gUserDefinedTypesInfo.size());
             Q_ASSERT(gUserDefinedTypesInfo.at(this->BaseMethod.returnType() - QHTTP_BASE_USER_DEFINED_TYPEID) != nullptr);
 
-            Result = gUserDefinedTypesInfo.at(this->BaseMethod.returnType() - QHTTP_BASE_USER_DEFINED_TYPEID)->invokeMethod(this, Arguments);
+            Result = gUserDefinedTypesInfo.at(this->BaseMethod.returnType() - QHTTP_BASE_USER_DEFINED_TYPEID)->invoke(
+                         this->BaseMethod.Invoker.data(), Arguments.Pointers.constData(), ArgumentsCount);
         }else{
             Q_ASSERT(this->BaseMethod.returnType() < gOrderedMetaTypeInfo.size());
             Q_ASSERT(gOrderedMetaTypeInfo.at(this->BaseMethod.returnType()) != nullptr);
 
-            Result = gOrderedMetaTypeInfo.at(this->BaseMethod.returnType())->invokeMethod(this, Arguments);
+            Result = gOrderedMetaTypeInfo.at(this->BaseMethod.returnType())->invoke(
+                         this->BaseMethod.Invoker.data(), Arguments.Pointers.constData(), ArgumentsCount);
         }
 
         if(this->Cache4Secs != 0)
@@ -296,75 +382,10 @@ public:
         else if(this->Cache4SecsCentral != 0)
             CentralCache::setValue(CacheKey, Result, this->Cache4SecsCentral);
 
-        gServerStats.APICallsStats[this->BaseMethod.name()].inc();
+        incServerStat(gServerStats.APICallsStats, this->BaseMethod.name());
         return Result;
     }
 
-#define USE_ARG_AT(_i) \
-    InvokableMethod.parameterType(_i) < QHTTP_BASE_USER_DEFINED_TYPEID ? \
-    gOrderedMetaTypeInfo.at(InvokableMethod.parameterType(_i))->makeGenericArgument(_arguments.at(_i), this->ParamNames.at(_i), &ArgStorage[_i]) : \
-    gUserDefinedTypesInfo.at(InvokableMethod.parameterType(_i) - QHTTP_BASE_USER_DEFINED_TYPEID)->makeGenericArgument(_arguments.at(_i), this->ParamNames.at(_i), &ArgStorage[_i])
-
-#define CLEAN_ARG_AT(_i) \
-    InvokableMethod.parameterType(_i) < QHTTP_BASE_USER_DEFINED_TYPEID ? \
-    gOrderedMetaTypeInfo.at(InvokableMethod.parameterType(_i))->cleanup(ArgStorage[_i]) : \
-    gUserDefinedTypesInfo.at(InvokableMethod.parameterType(_i) - QHTTP_BASE_USER_DEFINED_TYPEID)->cleanup(ArgStorage[_i])
-
-    void invokeMethod(const QVariantList& _arguments, QGenericReturnArgument _returnArg) const{
-        bool InvocationResult= true;
-        QMetaMethod InvokableMethod;
-        if(_arguments.size() == this->ParamNames.size())
-            InvokableMethod = this->BaseMethod;
-        else
-            InvokableMethod = this->LessArgumentMethods.at(this->ParamNames.size() - _arguments.size() - 1);
-
-        void* ArgStorage[_arguments.size()] = {};
-
-        try{
-            switch(_arguments.size()){
-            case  0: InvocationResult = InvokableMethod.invoke(this->parent(), this->IsAsync ? Qt::QueuedConnection : Qt::DirectConnection,
-                                                               _returnArg);break;
-            case  1: InvocationResult = InvokableMethod.invoke(this->parent(), this->IsAsync ? Qt::QueuedConnection : Qt::DirectConnection,
-                                                               _returnArg, USE_ARG_AT(0));break;
-            case  2: InvocationResult = InvokableMethod.invoke(this->parent(), this->IsAsync ? Qt::QueuedConnection : Qt::DirectConnection,
-                                                               _returnArg, USE_ARG_AT(0), USE_ARG_AT(1));break;
-            case  3: InvocationResult = InvokableMethod.invoke(this->parent(), this->IsAsync ? Qt::QueuedConnection : Qt::DirectConnection,
-                                                               _returnArg, USE_ARG_AT(0),USE_ARG_AT(1),USE_ARG_AT(2));break;
-            case  4: InvocationResult = InvokableMethod.invoke(this->parent(), this->IsAsync ? Qt::QueuedConnection : Qt::DirectConnection,
-                                                               _returnArg, USE_ARG_AT(0),USE_ARG_AT(1),USE_ARG_AT(2),USE_ARG_AT(3));break;
-            case  5: InvocationResult = InvokableMethod.invoke(this->parent(), this->IsAsync ? Qt::QueuedConnection : Qt::DirectConnection,
-                                                               _returnArg, USE_ARG_AT(0),USE_ARG_AT(1),USE_ARG_AT(2),USE_ARG_AT(3),USE_ARG_AT(4));break;
-            case  6: InvocationResult = InvokableMethod.invoke(this->parent(), this->IsAsync ? Qt::QueuedConnection : Qt::DirectConnection,
-                                                               _returnArg, USE_ARG_AT(0),USE_ARG_AT(1),USE_ARG_AT(2),USE_ARG_AT(3),USE_ARG_AT(4),
-                                                               USE_ARG_AT(5));break;
-            case  7: InvocationResult = InvokableMethod.invoke(this->parent(), this->IsAsync ? Qt::QueuedConnection : Qt::DirectConnection,
-                                                               _returnArg, USE_ARG_AT(0),USE_ARG_AT(1),USE_ARG_AT(2),USE_ARG_AT(3),USE_ARG_AT(4),
-                                                               USE_ARG_AT(5),USE_ARG_AT(6));break;
-            case  8: InvocationResult = InvokableMethod.invoke(this->parent(), this->IsAsync ? Qt::QueuedConnection : Qt::DirectConnection,
-                                                               _returnArg, USE_ARG_AT(0),USE_ARG_AT(1),USE_ARG_AT(2),USE_ARG_AT(3),USE_ARG_AT(4),
-                                                               USE_ARG_AT(5),USE_ARG_AT(6),USE_ARG_AT(7));break;
-            case  9: InvocationResult = InvokableMethod.invoke(this->parent(), this->IsAsync ? Qt::QueuedConnection : Qt::DirectConnection,
-                                                               _returnArg, USE_ARG_AT(0),USE_ARG_AT(1),USE_ARG_AT(2),USE_ARG_AT(3),USE_ARG_AT(4),
-                                                               USE_ARG_AT(5),USE_ARG_AT(6),USE_ARG_AT(7),USE_ARG_AT(8));break;
-            case 10: InvocationResult = InvokableMethod.invoke(this->parent(), this->IsAsync ? Qt::QueuedConnection : Qt::DirectConnection,
-                                                               _returnArg, USE_ARG_AT(0),USE_ARG_AT(1),USE_ARG_AT(2),USE_ARG_AT(3),USE_ARG_AT(4),
-                                                               USE_ARG_AT(5),USE_ARG_AT(6),USE_ARG_AT(7),USE_ARG_AT(8),USE_ARG_AT(9));break;
-            default:
-                throw exHTTPInternalServerError(QString("At most 10 method params are supported"));
-            }
-
-            if (InvocationResult == false)
-                throw exHTTPInternalServerError(QString("Unable to invoke method"));
-
-            for(int i=0; i< _arguments.size(); ++i)
-                CLEAN_ARG_AT(i);
-        }catch(...){
-            for(int i=0; i< _arguments.size(); ++i)
-                CLEAN_ARG_AT(i);
-            throw;
-        }
-    }
-
     bool isPolymorphic(const QMetaMethodExtended& _method){
         if(_method.parameterCount() == 0)
             return false;
@@ -375,24 +396,169 @@ public:
     }
 
 private:
+    /**
+     * @brief The enuParamSource enum specifies where value of each API parameter is taken from
+     */
+    enum enuParamSource : quint8 {
+        PARAM_SOURCE_Named,
+        PARAM_SOURCE_Cookies,
+        PARAM_SOURCE_Headers,
+        PARAM_SOURCE_JWT,
+        PARAM_SOURCE_RemoteIP,
+        PARAM_SOURCE_ExtraPath,
+        PARAM_SOURCE_AsyncResponse,
+        PARAM_SOURCE_DirectFilters,
+        PARAM_SOURCE_BodyStream,
+    };
+
+    /**
+     * @brief The stuParamBinding struct is the precompiled binding plan of each parameter so that invoke"()" does not need to
+     *        inspect parameter types on each call
+     */
+    struct stuParamBinding{
+        enuParamSource          Source;
+        QString                 Name;
+        QByteArray              NameBytes;
+        uint                    NameHash;
+        QString                 IndexName;
+        QByteArray              IndexNameBytes;
+        uint                    IndexNameHash;
+        intfAPIArgManipulator*  ArgManipulator;
+        size_t                  StorageOffset;
+    };
+
+    /**
+     * @brief The stuArguments struct holds arguments constructed in place on a buffer laid out by compileBindings"()" and
+     *        destroys the constructed ones when invocation is done or has failed
+     */
+    struct stuArguments{
+        stuArguments(const clsAPIObject* _apiObject) :
+            APIObject(_apiObject),
+            Storage(InlineStorage),
+            Pointers(_apiObject->Bindings.size())
+        {
+            if(_apiObject->ArgsStorageSize > sizeof(this->InlineStorage)){
+                this->HeapStorage.reset(new char[_apiObject->ArgsStorageSize]);
+                this->Storage = this->HeapStorage.data();
+            }
+            std::fill(this->Pointers.begin(), this->Pointers.end(), nullptr);
+        }
+        ~stuArguments(){
+            for(int i = this->Pointers.size() - 1; i >= 0; --i)
+                if(this->Pointers.at(i))
+                    this->APIObject->Bindings.at(i).ArgManipulator->cleanup(this->Pointers.at(i));
+        }
+        inline void* storage(quint8 _index) const { return this->Storage + this->APIObject->Bindings.at(_index).StorageOffset; }
+        inline void constructed(quint8 _index) { this->Pointers[_index] = this->storage(_index); }
+        inline bool isConstructed(quint8 _index) const { return this->Pointers.at(_index) != nullptr; }
+
+        const clsAPIObject*         APIObject;
+        alignas(std::max_align_t) char InlineStorage[QHTTP_INLINE_ARGS_STORAGE_SIZE];
+        QScopedArrayPointer<char>   HeapStorage;
+        char*                       Storage;
+        QVarLengthArray<void*, 16>  Pointers;
+    };
+
+    static QVariant parseJSONValue(const QString& _paramName, const QString& _value){
+        QString Error;
+        QJsonDocument JSON = clsJSONEngine::parse(_value.toUtf8(), &Error);
+        if(JSON.isNull())
+            throw exHTTPBadRequest(QString("Invalid value for %1: %2").arg(_paramName).arg(Error));
+        return JSON.toVariant();
+    }
+
+    static inline bool isJSONValue(const QString& _value){
+        return (_value.startsWith('[') && _value.endsWith(']')) ||
+               (_value.startsWith('{') && _value.endsWith('}'));
+    }
+
+    /**
+     * @brief bindString constructs the argument from its string value. Just JSON values are converted through QVariant
+     */
+    inline void bindString(const stuParamBinding& _binding, const QString& _value, void* _argStorage) const {
+        if(clsAPIObject::isJSONValue(_value))
+            _binding.ArgManipulator->constructArgument(clsAPIObject::parseJSONValue(_binding.Name, _value), _binding.NameBytes, _argStorage);
+        else
+            _binding.ArgManipulator->fromString(_value, _binding.NameBytes, _argStorage);
+    }
+
+    /**
+     * @brief bindJSON constructs the argument from the parsed JSON body. Strings are bound the same as query args
+     */
+    inline void bindJSON(const stuParamBinding& _binding, const QJsonValue& _value, void* _argStorage) const {
+        switch(_value.type()){
+        case QJsonValue::Null:   return _binding.ArgManipulator->fromString(QString(), _binding.NameBytes, _argStorage);
+        case QJsonValue::String: return this->bindString(_binding, _value.toString(), _argStorage);
+        default:                 return _binding.ArgManipulator->constructArgument(_value.toVariant(), _binding.NameBytes, _argStorage);
+        }
+    }
+
+    inline bool hasSource(enuParamSource _source) const {
+        return this->RequiredSources & (1u << _source);
+    }
+
+    void compileBindings(){
+        static const QMap<QString, enuParamSource> ImplicitSources = {
+            {PARAM_COOKIES,        PARAM_SOURCE_Cookies},
+            {PARAM_HEADERS,        PARAM_SOURCE_Headers},
+            {PARAM_JWT,            PARAM_SOURCE_JWT},
+            {PARAM_REMOTE_IP,      PARAM_SOURCE_RemoteIP},
+            {PARAM_EXTRAPATH,      PARAM_SOURCE_ExtraPath},
+            {PARAM_ASYNC_RESPONSE, PARAM_SOURCE_AsyncResponse},
+            {PARAM_DIRECTFILTER,   PARAM_SOURCE_DirectFilters},
+            {PARAM_BODY_STREAM,    PARAM_SOURCE_BodyStream},
+        };
+
+        for(quint8 i = 0; i < this->ParamNames.size(); ++i){
+            stuParamBinding Binding;
+            Binding.Source = ImplicitSources.value(this->ParamTypes.at(i), PARAM_SOURCE_Named);
+            Binding.Name = QString::fromLatin1(this->ParamNames.at(i));
+            Binding.NameBytes = this->ParamNames.at(i);
+            Binding.NameHash = clsQueryArgs::hash(Binding.NameBytes);
+            Binding.IndexName = QString::number(i);
+            Binding.IndexNameBytes = Binding.IndexName.toLatin1();
+            Binding.IndexNameHash = clsQueryArgs::hash(Binding.IndexNameBytes);
+            Binding.ArgManipulator = this->argSpecs(i);
+
+            size_t Alignment = Binding.ArgManipulator->storageAlignment();
+            Q_ASSERT(Alignment <= alignof(std::max_align_t));
+            Binding.StorageOffset = (this->ArgsStorageSize + Alignment - 1) & ~(Alignment - 1);
+            this->ArgsStorageSize = Binding.StorageOffset + Binding.ArgManipulator->storageSize();
+
+            this->RequiredSources |= 1u << Binding.Source;
+            if(Binding.Source == PARAM_SOURCE_Named)
+                ++this->NamedParamsCount;
+            else
+                ++this->ImplicitParamsCount;
+            this->Bindings.append(Binding);
+        }
+    }
+
     void updateDefaultValues(const QMetaMethodExtended& _method){
         if(_method.parameterNames().size() < this->RequiredParamsCount){
             this->RequiredParamsCount = static_cast<quint8>(_method.parameterNames().size());
-            this->LessArgumentMethods.append(_method);
         }
     }
 
 private:
     QMetaMethodExtended         BaseMethod;
-    QList<QMetaMethodExtended>  LessArgumentMethods;
     bool                        IsAsync;
     qint32                      Cache4Secs;
     qint32                      Cache4SecsCentral;
+    qint64                      MaxBodySize;
+    bool                        IsCoroutine;
     QList<QByteArray>           ParamNames;
     QList<QString>              ParamTypes;
+    QVector<stuParamBinding>    Bindings;
+    quint32                     RequiredSources = 0;
+    size_t                      ArgsStorageSize = 0;
+    quint8                      NamedParamsCount = 0;
+    quint8                      ImplicitParamsCount = 0;
     quint8                      RequiredParamsCount;
     bool                        HasExtraMethodName;
     intfRESTAPIHolder*          Parent;
+    QByteArray                  ModuleName;
+    mutable QAtomicInt          InFlight;
 
     friend class RESTAPIRegistry;
 };
@@ -0,0 +1,161 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#include <string.h>
+#include <QDeadlineTimer>
+#include "clsBodyStream.h"
+
+namespace QHttp {
+namespace Private {
+
+clsBodyStream::clsBodyStream(qint64 _highWatermark) :
+    HighWatermark(_highWatermark)
+{
+    this->open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+/**
+ * Queues a chunk received from socket. Returns false when unread data has exceeded high watermark and reading from socket
+ * must be paused until sigDrained is emitted.
+ */
+bool clsBodyStream::append(const QByteArray& _data)
+{
+    bool CanContinue = true;
+    {
+        QMutexLocker Locker(&this->Lock);
+        if(this->Finished || _data.isEmpty())
+            return true;
+        this->Chunks.enqueue(_data);
+        this->Buffered += _data.size();
+        if(this->HighWatermark && this->Buffered > this->HighWatermark){
+            this->Paused = true;
+            CanContinue = false;
+        }
+        this->HasData.wakeAll();
+    }
+    emit this->readyRead();
+    return CanContinue;
+}
+
+void clsBodyStream::finish()
+{
+    {
+        QMutexLocker Locker(&this->Lock);
+        this->Finished = true;
+        this->HasData.wakeAll();
+    }
+    emit this->readChannelFinished();
+}
+
+/**
+ * Drops unread data and ends the stream. Readers see end of data as when the body is finished so they must check
+ * isAborted"()" to distinguish a truncated body.
+ */
+void clsBodyStream::abort(const QString& _reason)
+{
+    {
+        QMutexLocker Locker(&this->Lock);
+        if(this->Finished && this->Chunks.isEmpty())
+            return;
+        this->Chunks.clear();
+        this->Buffered = 0;
+        this->Finished = true;
+        this->Aborted = true;
+        this->AbortReason = _reason;
+        this->HasData.wakeAll();
+    }
+    this->setErrorString(_reason);
+    emit this->readChannelFinished();
+}
+
+qint64 clsBodyStream::bufferedBytes() const
+{
+    QMutexLocker Locker(&this->Lock);
+    return this->Buffered;
+}
+
+bool clsBodyStream::isAborted() const
+{
+    QMutexLocker Locker(&this->Lock);
+    return this->Aborted;
+}
+
+QString clsBodyStream::abortReason() const
+{
+    QMutexLocker Locker(&this->Lock);
+    return this->AbortReason;
+}
+
+qint64 clsBodyStream::bytesAvailable() const
+{
+    return this->bufferedBytes() + QIODevice::bytesAvailable();
+}
+
+bool clsBodyStream::atEnd() const
+{
+    QMutexLocker Locker(&this->Lock);
+    return this->Finished && this->Buffered == 0;
+}
+
+bool clsBodyStream::waitForReadyRead(int _msecs)
+{
+    QDeadlineTimer Deadline(_msecs);
+    QMutexLocker Locker(&this->Lock);
+    while(this->Buffered == 0 && this->Finished == false)
+        if(this->HasData.wait(&this->Lock, Deadline) == false)
+            return false;
+    return this->Buffered > 0;
+}
+
+qint64 clsBodyStream::readData(char* _data, qint64 _maxSize)
+{
+    qint64 Read = 0;
+    bool Drained = false;
+    {
+        QMutexLocker Locker(&this->Lock);
+        while(Read < _maxSize && this->Chunks.size()){
+            const QByteArray& Chunk = this->Chunks.head();
+            qint64 Size = qMin(_maxSize - Read, static_cast<qint64>(Chunk.size() - this->FirstChunkOffset));
+            memcpy(_data + Read, Chunk.constData() + this->FirstChunkOffset, static_cast<size_t>(Size));
+            Read += Size;
+            this->FirstChunkOffset += static_cast<int>(Size);
+            if(this->FirstChunkOffset == Chunk.size()){
+                this->Chunks.dequeue();
+                this->FirstChunkOffset = 0;
+            }
+        }
+        this->Buffered -= Read;
+        if(this->Paused && this->Buffered <= this->HighWatermark / 2){
+            this->Paused = false;
+            Drained = true;
+        }
+        if(Read == 0 && this->Finished)
+            return -1;
+    }
+    if(Drained)
+        emit this->sigDrained();
+    return Read;
+}
+
+}
+}
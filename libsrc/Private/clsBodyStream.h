@@ -0,0 +1,82 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#ifndef QHTTP_PRIVATE_CLSBODYSTREAM_H
+#define QHTTP_PRIVATE_CLSBODYSTREAM_H
+
+#include <QIODevice>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+
+namespace QHttp {
+namespace Private {
+
+/**
+ * @brief The clsBodyStream class is a sequential read-only device filled by the request handler as body chunks arrive and
+ *        consumed by APIs through QHttp::BodyStream_t. Chunks are queued without copying and the device can be read from
+ *        any thread. sigDrained is emitted by the reader once buffered data drops below low watermark so the request
+ *        handler can resume reading from socket.
+ */
+class clsBodyStream : public QIODevice
+{
+    Q_OBJECT
+public:
+    clsBodyStream(qint64 _highWatermark);
+
+    bool append(const QByteArray& _data);
+    void finish();
+    void abort(const QString& _reason);
+
+    qint64 bufferedBytes() const;
+    bool isAborted() const;
+    QString abortReason() const;
+    bool isSequential() const Q_DECL_FINAL { return true; }
+    qint64 bytesAvailable() const Q_DECL_FINAL;
+    bool atEnd() const Q_DECL_FINAL;
+    bool waitForReadyRead(int _msecs) Q_DECL_FINAL;
+
+signals:
+    void sigDrained();
+
+private:
+    qint64 readData(char* _data, qint64 _maxSize) Q_DECL_FINAL;
+    qint64 writeData(const char*, qint64) Q_DECL_FINAL { return -1; }
+
+private:
+    mutable QMutex      Lock;
+    QWaitCondition      HasData;
+    QQueue<QByteArray>  Chunks;
+    int                 FirstChunkOffset = 0;
+    qint64              Buffered = 0;
+    qint64              HighWatermark;
+    bool                Finished = false;
+    bool                Aborted = false;
+    bool                Paused = false;
+    QString             AbortReason;
+};
+
+}
+}
+
+#endif // QHTTP_PRIVATE_CLSBODYSTREAM_H
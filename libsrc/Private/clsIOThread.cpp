@@ -0,0 +1,182 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <QTimer>
+#include "libTargomanCommon/Logger.h"
+#include "clsIOThread.h"
+#include "Configs.hpp"
+
+namespace QHttp {
+namespace Private {
+
+using namespace qhttp::server;
+
+clsHTTPListener::clsHTTPListener(const fnNewConnection_t& _onNewConnection,
+                                 const TServerHandler& _onNewRequest,
+                                 QObject* _parent) :
+    QTcpServer(_parent)
+{
+    QObject::connect(&this->HTTPServer, &QHttpServer::newConnection, this, _onNewConnection);
+    QObject::connect(&this->HTTPServer, &QHttpServer::newRequest, this, _onNewRequest);
+}
+
+bool clsHTTPListener::listenReusePort(const QHostAddress& _address, quint16 _port)
+{
+    union {
+        sockaddr_in  V4;
+        sockaddr_in6 V6;
+    } Address;
+    memset(&Address, 0, sizeof(Address));
+    socklen_t AddressLen;
+    bool DualStack = false;
+
+    if(_address.protocol() == QAbstractSocket::IPv4Protocol){
+        Address.V4.sin_family = AF_INET;
+        Address.V4.sin_port = htons(_port);
+        Address.V4.sin_addr.s_addr = htonl(_address.toIPv4Address());
+        AddressLen = sizeof(Address.V4);
+    }else{
+        Address.V6.sin6_family = AF_INET6;
+        Address.V6.sin6_port = htons(_port);
+        if(_address.protocol() == QAbstractSocket::IPv6Protocol){
+            Q_IPV6ADDR IPv6 = _address.toIPv6Address();
+            memcpy(&Address.V6.sin6_addr, &IPv6, sizeof(IPv6));
+        }else{
+            Address.V6.sin6_addr = in6addr_any;
+            DualStack = true;
+        }
+        AddressLen = sizeof(Address.V6);
+    }
+
+    int Socket = ::socket(reinterpret_cast<sockaddr*>(&Address)->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(Socket < 0 && DualStack){
+        /* IPv6 is not available so fallback to IPv4 any address */
+        memset(&Address, 0, sizeof(Address));
+        Address.V4.sin_family = AF_INET;
+        Address.V4.sin_port = htons(_port);
+        Address.V4.sin_addr.s_addr = htonl(INADDR_ANY);
+        AddressLen = sizeof(Address.V4);
+        DualStack = false;
+        Socket = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    }
+
+    if(Socket < 0){
+        TargomanLogError("Unable to create listening socket: "<<strerror(errno));
+        return false;
+    }
+
+    int On = 1, Off = 0;
+    if(::setsockopt(Socket, SOL_SOCKET, SO_REUSEADDR, &On, sizeof(On)) ||
+       ::setsockopt(Socket, SOL_SOCKET, SO_REUSEPORT, &On, sizeof(On)) ||
+       (DualStack && ::setsockopt(Socket, IPPROTO_IPV6, IPV6_V6ONLY, &Off, sizeof(Off))) ||
+       ::bind(Socket, reinterpret_cast<sockaddr*>(&Address), AddressLen) ||
+       ::listen(Socket, SOMAXCONN)){
+        TargomanLogError("Unable to listen on "<<_address.toString()<<":"<<_port<<": "<<strerror(errno));
+        ::close(Socket);
+        return false;
+    }
+
+    if(this->setSocketDescriptor(Socket) == false){
+        TargomanLogError("Unable to use listening socket: "<<this->errorString());
+        ::close(Socket);
+        return false;
+    }
+    return true;
+}
+
+bool clsHTTPListener::adoptSocket(qintptr _socket)
+{
+    if(this->setSocketDescriptor(_socket) == false){
+        TargomanLogError("Unable to adopt handed off listening socket: "<<this->errorString());
+        ::close(static_cast<int>(_socket));
+        return false;
+    }
+    return true;
+}
+
+void clsHTTPListener::incomingConnection(qintptr _handle)
+{
+    this->HTTPServer.acceptConnection(_handle);
+}
+
+/***********************************************************************************************/
+clsIOThread::clsIOThread(const fnNewConnection_t& _onNewConnection, const TServerHandler& _onNewRequest, qintptr _adoptedSocket) :
+    OnNewConnection(_onNewConnection),
+    OnNewRequest(_onNewRequest),
+    IsListening(false),
+    ListeningSocket(_adoptedSocket),
+    Listener(nullptr)
+{}
+
+bool clsIOThread::startListening()
+{
+    this->start();
+    this->ListenerReady.acquire();
+    if(this->IsListening == false)
+        this->wait();
+    return this->IsListening;
+}
+
+void clsIOThread::stopAccepting()
+{
+    /* Listener must be closed on its own thread while the event loop keeps serving accepted connections. Posted call is
+       dropped by Qt if the listener is destroyed meanwhile, and the lock keeps it alive until the call is posted */
+    QMutexLocker Locker(&this->ListenerLock);
+    if(this->Listener){
+        clsHTTPListener* Listener = this->Listener;
+        QTimer::singleShot(0, Listener, [Listener](){ Listener->close(); });
+    }
+}
+
+void clsIOThread::stopListening()
+{
+    this->quit();
+    this->wait();
+}
+
+void clsIOThread::run()
+{
+    clsHTTPListener Listener(this->OnNewConnection, this->OnNewRequest);
+    if(this->ListeningSocket >= 0)
+        this->IsListening = Listener.adoptSocket(this->ListeningSocket);
+    else
+        this->IsListening = Listener.listenReusePort(gConfigs.Public.ListenAddress, gConfigs.Public.ListenPort);
+    this->ListeningSocket = Listener.socketDescriptor();
+    {
+        QMutexLocker Locker(&this->ListenerLock);
+        this->Listener = &Listener;
+    }
+    this->ListenerReady.release();
+    if(this->IsListening)
+        this->exec();
+    QMutexLocker Locker(&this->ListenerLock);
+    this->Listener = nullptr;
+}
+
+}
+}
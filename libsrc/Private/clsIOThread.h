@@ -0,0 +1,100 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#ifndef QHTTP_PRIVATE_CLSIOTHREAD_H
+#define QHTTP_PRIVATE_CLSIOTHREAD_H
+
+#include <functional>
+#include <QThread>
+#include <QTcpServer>
+#include <QSemaphore>
+#include <QMutex>
+#include "QHttp/QHttpServer"
+
+namespace QHttp {
+namespace Private {
+
+typedef std::function<void(qhttp::server::QHttpConnection*)> fnNewConnection_t;
+
+/**
+ * @brief The clsHTTPServer class just exposes connection adoption of QHttpServer so that sockets accepted
+ *        by clsHTTPListener can be served without QHttpServer owning the listening socket
+ */
+class clsHTTPServer : public qhttp::server::QHttpServer{
+public:
+    clsHTTPServer(QObject* _parent = nullptr) : QHttpServer(_parent){}
+    void acceptConnection(qintptr _handle) { this->incomingConnection(_handle); }
+};
+
+/**
+ * @brief The clsHTTPListener class listens on a SO_REUSEPORT socket so that multiple listeners (one per IO thread)
+ *        can be bound on the same address/port and kernel will balance incoming connections between them
+ */
+class clsHTTPListener : public QTcpServer{
+public:
+    clsHTTPListener(const fnNewConnection_t& _onNewConnection,
+                    const qhttp::server::TServerHandler& _onNewRequest,
+                    QObject* _parent = nullptr);
+
+    bool listenReusePort(const QHostAddress& _address, quint16 _port);
+    bool adoptSocket(qintptr _socket);
+
+protected:
+    void incomingConnection(qintptr _handle) Q_DECL_FINAL;
+
+private:
+    clsHTTPServer HTTPServer;
+};
+
+/**
+ * @brief The clsIOThread class runs a clsHTTPListener on its own event loop. All the connections accepted by
+ *        the listener are parsed and responded on this thread.
+ */
+class clsIOThread : public QThread{
+public:
+    clsIOThread(const fnNewConnection_t& _onNewConnection,
+                const qhttp::server::TServerHandler& _onNewRequest,
+                qintptr _adoptedSocket = -1);
+
+    bool startListening();
+    void stopAccepting();
+    void stopListening();
+    inline qintptr listeningSocket() const { return this->ListeningSocket; }
+
+private:
+    void run() Q_DECL_FINAL;
+
+private:
+    fnNewConnection_t                OnNewConnection;
+    qhttp::server::TServerHandler    OnNewRequest;
+    QSemaphore                       ListenerReady;
+    bool                             IsListening;
+    qintptr                          ListeningSocket;
+    QMutex                           ListenerLock;
+    clsHTTPListener*                 Listener;
+};
+
+}
+}
+
+#endif // QHTTP_PRIVATE_CLSIOTHREAD_H
@@ -0,0 +1,258 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#include <QFile>
+#include <QMutex>
+#include <QThread>
+#include "libTargomanCommon/exTargomanBase.h"
+#include "clsIPBlockList.h"
+
+namespace QHttp {
+namespace Private {
+
+using namespace Targoman::Common;
+
+static constexpr quint32 ROOT_NODE = 0;
+static constexpr qint8   NO_STATUS = -1;
+
+static inline void toKey(const Q_IPV6ADDR& _address, quint64& _hi, quint64& _lo){
+    _hi = 0;
+    _lo = 0;
+    for(int i = 0; i < 8; ++i){
+        _hi = (_hi << 8) | _address.c[i];
+        _lo = (_lo << 8) | _address.c[i + 8];
+    }
+}
+
+static inline void maskKey(quint64& _hi, quint64& _lo, quint8 _length){
+    if(_length == 0){
+        _hi = _lo = 0;
+    }else if(_length < 64){
+        _hi &= ~0ull << (64 - _length);
+        _lo = 0;
+    }else if(_length == 64){
+        _lo = 0;
+    }else if(_length < 128){
+        _lo &= ~0ull << (128 - _length);
+    }
+}
+
+static inline quint8 bitAt(quint64 _hi, quint64 _lo, quint8 _index){
+    return _index < 64 ? (_hi >> (63 - _index)) & 1 : (_lo >> (127 - _index)) & 1;
+}
+
+static inline quint8 commonPrefixLength(quint64 _hi1, quint64 _lo1, quint64 _hi2, quint64 _lo2, quint8 _maxLength){
+    quint8 Length;
+    if(_hi1 != _hi2)
+        Length = static_cast<quint8>(__builtin_clzll(_hi1 ^ _hi2));
+    else if(_lo1 != _lo2)
+        Length = static_cast<quint8>(64 + __builtin_clzll(_lo1 ^ _lo2));
+    else
+        Length = 128;
+    return qMin(Length, _maxLength);
+}
+
+/***********************************************************************************************/
+clsIPTrie::clsIPTrie()
+{
+    this->Nodes.push_back(stuNode{0, 0, {0, 0}, 0, NO_STATUS});
+}
+
+void clsIPTrie::insert(const Q_IPV6ADDR& _address, quint8 _prefixLength, enuIPBlackListStatus::Type _status)
+{
+    quint64 Hi, Lo;
+    toKey(_address, Hi, Lo);
+    maskKey(Hi, Lo, _prefixLength);
+    qint8 Status = static_cast<qint8>(_status);
+
+    auto newNode = [this](quint64 _hi, quint64 _lo, quint8 _length, qint8 _status) -> quint32 {
+        this->Nodes.push_back(stuNode{_hi, _lo, {0, 0}, _length, _status});
+        return static_cast<quint32>(this->Nodes.size() - 1);
+    };
+
+    quint32 NodeIndex = ROOT_NODE;
+    forever{
+        if(this->Nodes[NodeIndex].Length == _prefixLength){
+            if(this->Nodes[NodeIndex].Status == NO_STATUS)
+                ++this->PrefixesCount;
+            this->Nodes[NodeIndex].Status = Status;
+            return;
+        }
+
+        quint8  Branch = bitAt(Hi, Lo, this->Nodes[NodeIndex].Length);
+        quint32 ChildIndex = this->Nodes[NodeIndex].Child[Branch];
+        if(ChildIndex == 0){
+            quint32 Leaf = newNode(Hi, Lo, _prefixLength, Status);
+            this->Nodes[NodeIndex].Child[Branch] = Leaf;
+            ++this->PrefixesCount;
+            return;
+        }
+
+        const stuNode& Child = this->Nodes[ChildIndex];
+        quint8 Common = commonPrefixLength(Hi, Lo, Child.Hi, Child.Lo, qMin(_prefixLength, Child.Length));
+        if(Common == Child.Length){
+            NodeIndex = ChildIndex;
+            continue;
+        }
+
+        quint8 ChildBranch = bitAt(Child.Hi, Child.Lo, Common);
+        quint32 SplitNode;
+        if(Common == _prefixLength){
+            SplitNode = newNode(Hi, Lo, _prefixLength, Status);
+        }else{
+            quint64 SplitHi = Hi, SplitLo = Lo;
+            maskKey(SplitHi, SplitLo, Common);
+            SplitNode = newNode(SplitHi, SplitLo, Common, NO_STATUS);
+            this->Nodes[SplitNode].Child[bitAt(Hi, Lo, Common)] = newNode(Hi, Lo, _prefixLength, Status);
+        }
+        this->Nodes[SplitNode].Child[ChildBranch] = ChildIndex;
+        this->Nodes[NodeIndex].Child[Branch] = SplitNode;
+        ++this->PrefixesCount;
+        return;
+    }
+}
+
+enuIPBlackListStatus::Type clsIPTrie::lookup(const Q_IPV6ADDR& _address) const
+{
+    quint64 Hi, Lo;
+    toKey(_address, Hi, Lo);
+
+    qint8 BestStatus = NO_STATUS;
+    const stuNode* Node = &this->Nodes[ROOT_NODE];
+    forever{
+        if(commonPrefixLength(Hi, Lo, Node->Hi, Node->Lo, Node->Length) < Node->Length)
+            break;
+        if(Node->Status != NO_STATUS)
+            BestStatus = Node->Status;
+        if(Node->Length == 128)
+            break;
+        quint32 ChildIndex = Node->Child[bitAt(Hi, Lo, Node->Length)];
+        if(ChildIndex == 0)
+            break;
+        Node = &this->Nodes[ChildIndex];
+    }
+
+    return BestStatus == NO_STATUS ? enuIPBlackListStatus::Unknown : static_cast<enuIPBlackListStatus::Type>(BestStatus);
+}
+
+/***********************************************************************************************/
+std::atomic<const clsIPTrie*> clsIPBlockList::Active(nullptr);
+std::atomic<quint32>          clsIPBlockList::Epoch(0);
+std::atomic<quint32>          clsIPBlockList::Readers[2] = {{0}, {0}};
+static QMutex                 gReloadLock;
+
+static inline Q_IPV6ADDR toIPv6(const QHostAddress& _address){
+    if(_address.protocol() != QAbstractSocket::IPv4Protocol)
+        return _address.toIPv6Address();
+
+    Q_IPV6ADDR Mapped = {};
+    quint32 IPv4 = _address.toIPv4Address();
+    Mapped.c[10] = 0xff;
+    Mapped.c[11] = 0xff;
+    Mapped.c[12] = static_cast<quint8>(IPv4 >> 24);
+    Mapped.c[13] = static_cast<quint8>(IPv4 >> 16);
+    Mapped.c[14] = static_cast<quint8>(IPv4 >> 8);
+    Mapped.c[15] = static_cast<quint8>(IPv4);
+    return Mapped;
+}
+
+size_t clsIPBlockList::reload(const QString& _filePath)
+{
+    QFile File(_filePath);
+    if(File.open(QFile::ReadOnly) == false)
+        throw exTargomanInitialization("Unable to open IP block list file: " + _filePath);
+
+    clsIPTrie* Trie = new clsIPTrie;
+    quint32 LineNumber = 0;
+    while(File.atEnd() == false){
+        QByteArray Line = File.readLine().trimmed();
+        ++LineNumber;
+        if(Line.isEmpty() || Line.startsWith('#'))
+            continue;
+
+        QList<QByteArray> Parts = Line.simplified().split(' ');
+        QPair<QHostAddress, int> Subnet = QHostAddress::parseSubnet(Parts.first());
+        if(Subnet.second < 0){
+            delete Trie;
+            throw exTargomanInitialization(QString("Invalid CIDR at %1:%2").arg(_filePath).arg(LineNumber));
+        }
+
+        enuIPBlackListStatus::Type Status = enuIPBlackListStatus::Banned;
+        if(Parts.size() > 1){
+            if(enuIPBlackListStatus::options().contains(QString(Parts.at(1))) == false){
+                delete Trie;
+                throw exTargomanInitialization(QString("Invalid status at %1:%2").arg(_filePath).arg(LineNumber));
+            }
+            Status = enuIPBlackListStatus::toEnum(QString(Parts.at(1)));
+        }
+
+        quint8 PrefixLength = static_cast<quint8>(Subnet.first.protocol() == QAbstractSocket::IPv4Protocol ? Subnet.second + 96 : Subnet.second);
+        Trie->insert(toIPv6(Subnet.first), PrefixLength, Status);
+    }
+
+    size_t Size = Trie->size();
+    clsIPBlockList::replace(Trie);
+    return Size;
+}
+
+void clsIPBlockList::clear()
+{
+    clsIPBlockList::replace(nullptr);
+}
+
+/**
+ * New readers are moved to the next epoch after the trie is swapped, so readers of the previous epoch (the only ones
+ * which may hold the old trie) drain even under constant load.
+ */
+void clsIPBlockList::replace(const clsIPTrie* _trie)
+{
+    QMutexLocker Locker(&gReloadLock);
+    const clsIPTrie* Old = clsIPBlockList::Active.exchange(_trie);
+    quint32 OldEpoch = clsIPBlockList::Epoch.fetch_add(1) & 1;
+    while(clsIPBlockList::Readers[OldEpoch].load())
+        QThread::yieldCurrentThread();
+    delete Old;
+}
+
+enuIPBlackListStatus::Type clsIPBlockList::status(const QHostAddress& _address)
+{
+    /* Registration is valid just when epoch has not changed meanwhile, otherwise a reload may have already checked the
+       counter and the next one would not wait for this reader */
+    std::atomic<quint32>* pReaders;
+    forever{
+        quint32 CurrentEpoch = clsIPBlockList::Epoch.load();
+        pReaders = &clsIPBlockList::Readers[CurrentEpoch & 1];
+        pReaders->fetch_add(1);
+        if(clsIPBlockList::Epoch.load() == CurrentEpoch)
+            break;
+        pReaders->fetch_sub(1);
+    }
+    std::atomic<quint32>& Readers = *pReaders;
+    const clsIPTrie* Trie = clsIPBlockList::Active.load();
+    enuIPBlackListStatus::Type Status = Trie ? Trie->lookup(toIPv6(_address)) : enuIPBlackListStatus::Unknown;
+    Readers.fetch_sub(1);
+    return Status;
+}
+
+}
+}
@@ -0,0 +1,83 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#ifndef QHTTP_PRIVATE_CLSIPBLOCKLIST_H
+#define QHTTP_PRIVATE_CLSIPBLOCKLIST_H
+
+#include <atomic>
+#include <vector>
+#include <QHostAddress>
+#include "QRESTServer.h"
+
+namespace QHttp {
+namespace Private {
+
+/**
+ * @brief The clsIPTrie class is an immutable path-compressed binary radix trie over IPv6 addresses. IPv4 prefixes are
+ *        stored as IPv4-mapped IPv6 prefixes. Lookups return status of the longest matching prefix.
+ */
+class clsIPTrie
+{
+public:
+    clsIPTrie();
+    void insert(const Q_IPV6ADDR& _address, quint8 _prefixLength, enuIPBlackListStatus::Type _status);
+    enuIPBlackListStatus::Type lookup(const Q_IPV6ADDR& _address) const;
+    inline size_t size() const { return this->PrefixesCount; }
+
+private:
+    struct stuNode{
+        quint64 Hi;
+        quint64 Lo;
+        quint32 Child[2];
+        quint8  Length;
+        qint8   Status;
+    };
+
+    std::vector<stuNode> Nodes;
+    size_t               PrefixesCount = 0;
+};
+
+/**
+ * @brief The clsIPBlockList class holds the active clsIPTrie. Lookups are lock-free as the trie is swapped atomically on reload.
+ *        Readers are counted per epoch and the replaced trie is deleted once all readers of its epoch are done with it.
+ */
+class clsIPBlockList
+{
+public:
+    static size_t reload(const QString& _filePath);
+    static void clear();
+    static enuIPBlackListStatus::Type status(const QHostAddress& _address);
+
+private:
+    static void replace(const clsIPTrie* _trie);
+
+private:
+    static std::atomic<const clsIPTrie*> Active;
+    static std::atomic<quint32>          Epoch;
+    static std::atomic<quint32>          Readers[2];
+};
+
+}
+}
+
+#endif // QHTTP_PRIVATE_CLSIPBLOCKLIST_H
@@ -0,0 +1,108 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#include <QJsonObject>
+#include <QJsonArray>
+#include "clsJSONEngine.h"
+
+#ifdef QHTTP_ENABLE_SIMDJSON
+#include <simdjson.h>
+#endif
+
+namespace QHttp {
+namespace Private {
+
+#ifdef QHTTP_ENABLE_SIMDJSON
+static QJsonValue toQJsonValue(simdjson::dom::element _element){
+    switch(_element.type()){
+    case simdjson::dom::element_type::ARRAY:{
+        QJsonArray Array;
+        for(simdjson::dom::element Item : _element.get_array().value_unsafe())
+            Array.append(toQJsonValue(Item));
+        return Array;
+    }
+    case simdjson::dom::element_type::OBJECT:{
+        QJsonObject Object;
+        for(simdjson::dom::key_value_pair Field : _element.get_object().value_unsafe())
+            Object.insert(QString::fromUtf8(Field.key.data(), static_cast<int>(Field.key.size())), toQJsonValue(Field.value));
+        return Object;
+    }
+    case simdjson::dom::element_type::STRING:{
+        std::string_view String = _element.get_string().value_unsafe();
+        return QString::fromUtf8(String.data(), static_cast<int>(String.size()));
+    }
+    case simdjson::dom::element_type::INT64:
+        return static_cast<double>(_element.get_int64().value_unsafe());
+    case simdjson::dom::element_type::UINT64:
+        return static_cast<double>(_element.get_uint64().value_unsafe());
+    case simdjson::dom::element_type::DOUBLE:
+        return _element.get_double().value_unsafe();
+    case simdjson::dom::element_type::BOOL:
+        return _element.get_bool().value_unsafe();
+    case simdjson::dom::element_type::NULL_VALUE:
+    default:
+        return QJsonValue(QJsonValue::Null);
+    }
+}
+#endif
+
+QJsonDocument clsJSONEngine::parse(const QByteArray& _json, QString* _error)
+{
+#ifdef QHTTP_ENABLE_SIMDJSON
+    /* Parser keeps its buffers between calls so each thread reuses its own one */
+    static thread_local simdjson::dom::parser Parser;
+    simdjson::dom::element Root;
+    simdjson::error_code Error = Parser.parse(_json.constData(), static_cast<size_t>(_json.size())).get(Root);
+    if(Error != simdjson::SUCCESS){
+        if(_error)
+            *_error = simdjson::error_message(Error);
+        return QJsonDocument();
+    }
+    switch(Root.type()){
+    case simdjson::dom::element_type::OBJECT: return QJsonDocument(toQJsonValue(Root).toObject());
+    case simdjson::dom::element_type::ARRAY:  return QJsonDocument(toQJsonValue(Root).toArray());
+    default:
+        if(_error)
+            *_error = "JSON document must be an object or array";
+        return QJsonDocument();
+    }
+#else
+    QJsonParseError Error;
+    QJsonDocument Document = QJsonDocument::fromJson(_json, &Error);
+    if(Document.isNull() && _error)
+        *_error = Error.errorString();
+    return Document;
+#endif
+}
+
+const char* clsJSONEngine::name()
+{
+#ifdef QHTTP_ENABLE_SIMDJSON
+    return "simdjson";
+#else
+    return "QJsonDocument";
+#endif
+}
+
+}
+}
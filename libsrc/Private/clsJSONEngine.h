@@ -0,0 +1,51 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#ifndef QHTTP_PRIVATE_CLSJSONENGINE_H
+#define QHTTP_PRIVATE_CLSJSONENGINE_H
+
+#include <QJsonDocument>
+#include <QString>
+
+namespace QHttp {
+namespace Private {
+
+/**
+ * @brief The clsJSONEngine class is the single entry point used to parse JSON input (request bodies, JSON_t parameters,
+ *        websocket messages and JWT payloads). When compiled with QHTTP_ENABLE_SIMDJSON input is validated and parsed by
+ *        simdjson directly from UTF-8 and converted to Qt JSON types in one pass, otherwise QJsonDocument is used.
+ */
+class clsJSONEngine
+{
+public:
+    /**
+     * @brief parse parses _json and returns a null document on failure, reporting the reason in _error when provided
+     */
+    static QJsonDocument parse(const QByteArray& _json, QString* _error = nullptr);
+    static const char* name();
+};
+
+}
+}
+
+#endif // QHTTP_PRIVATE_CLSJSONENGINE_H
@@ -0,0 +1,238 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#include <algorithm>
+#include <string.h>
+#include <ctype.h>
+#include "clsMultipartParser.h"
+
+namespace QHttp {
+namespace Private {
+
+static constexpr size_t MAX_PART_HEADERS_SIZE = 16 * 1024;
+
+static inline std::string toLower(std::string _str){
+    std::transform(_str.begin(), _str.end(), _str.begin(), [](unsigned char _char){ return static_cast<char>(tolower(_char)); });
+    return _str;
+}
+
+std::string stuMultipartHeaders::value(std::string _name) const
+{
+    auto Iter = this->find(toLower(_name));
+    return Iter == this->end() ? std::string() : Iter->second;
+}
+
+clsMultipartParser::clsMultipartParser(const std::string& _boundary) :
+    Delimiter("\r\n--" + _boundary),
+    State(STATE_Preamble),
+    /* First delimiter has no leading CRLF so parsing starts as if it has been seen */
+    Pending("\r\n")
+{
+    size_t Size = this->Delimiter.size();
+    for(size_t i = 0; i < 256; ++i)
+        this->Skip[i] = Size;
+    for(size_t i = 0; i + 1 < Size; ++i)
+        this->Skip[static_cast<unsigned char>(this->Delimiter[i])] = Size - 1 - i;
+}
+
+size_t clsMultipartParser::feed(const char* _buffer, size_t _size)
+{
+    size_t Pos = 0;
+    while(Pos < _size && this->stopped() == false){
+        switch(this->State){
+        case STATE_Preamble:
+        case STATE_Data:
+            Pos += this->scanBody(_buffer + Pos, _size - Pos);
+            break;
+
+        case STATE_AfterDelimiter:
+            switch(_buffer[Pos++]){
+            case '-':  this->State = STATE_AfterDelimiterHyphen; break;
+            case '\r': this->State = STATE_AfterDelimiterCR; break;
+            case ' ':
+            case '\t': break;
+            default:   this->setError("Invalid character after multipart delimiter");
+            }
+            break;
+
+        case STATE_AfterDelimiterHyphen:
+            if(_buffer[Pos++] != '-')
+                return this->setError("Invalid closing multipart delimiter"), Pos;
+            this->State = STATE_End;
+            this->onEnd();
+            break;
+
+        case STATE_AfterDelimiterCR:
+            if(_buffer[Pos++] != '\n')
+                return this->setError("Invalid line ending after multipart delimiter"), Pos;
+            this->HeaderBuffer.clear();
+            this->State = STATE_Headers;
+            break;
+
+        case STATE_Headers:{
+            const char* End = static_cast<const char*>(memchr(_buffer + Pos, '\n', _size - Pos));
+            size_t Length = (End ? static_cast<size_t>(End - _buffer) + 1 : _size) - Pos;
+            this->HeaderBuffer.append(_buffer + Pos, Length);
+            Pos += Length;
+            if(this->HeaderBuffer.size() > MAX_PART_HEADERS_SIZE)
+                return this->setError("Multipart headers are too large"), Pos;
+
+            size_t HeaderSize = this->HeaderBuffer.size();
+            if(this->HeaderBuffer == "\r\n" ||
+               (HeaderSize >= 4 && this->HeaderBuffer.compare(HeaderSize - 4, 4, "\r\n\r\n") == 0)){
+                if(this->parseHeaders() == false)
+                    return Pos;
+                this->State = STATE_Data;
+            }
+            break;
+        }
+
+        case STATE_End:
+        case STATE_Error:
+            break;
+        }
+    }
+    return Pos;
+}
+
+size_t clsMultipartParser::findDelimiter(const char* _buffer, size_t _size) const
+{
+    const size_t Size = this->Delimiter.size();
+    if(_size < Size)
+        return std::string::npos;
+
+    const char* Pattern = this->Delimiter.data();
+    const char  Last = Pattern[Size - 1];
+    for(size_t i = 0; i <= _size - Size; ){
+        char Char = _buffer[i + Size - 1];
+        if(Char == Last && memcmp(_buffer + i, Pattern, Size - 1) == 0)
+            return i;
+        i += this->Skip[static_cast<unsigned char>(Char)];
+    }
+    return std::string::npos;
+}
+
+size_t clsMultipartParser::partialDelimiterAt(const char* _buffer, size_t _size) const
+{
+    size_t From = _size >= this->Delimiter.size() ? _size - this->Delimiter.size() + 1 : 0;
+    const char* End = _buffer + _size;
+    for(const char* Candidate = static_cast<const char*>(memchr(_buffer + From, '\r', _size - From));
+        Candidate;
+        Candidate = static_cast<const char*>(memchr(Candidate + 1, '\r', static_cast<size_t>(End - Candidate - 1))))
+        if(memcmp(Candidate, this->Delimiter.data(), static_cast<size_t>(End - Candidate)) == 0)
+            return static_cast<size_t>(Candidate - _buffer);
+    return _size;
+}
+
+size_t clsMultipartParser::scanBody(const char* _buffer, size_t _size)
+{
+    if(this->Pending.size())
+        return this->resumePartialDelimiter(_buffer, _size);
+
+    size_t Found = this->findDelimiter(_buffer, _size);
+    if(Found != std::string::npos){
+        this->emitData(_buffer, Found);
+        if(this->State == STATE_Data)
+            this->onPartEnd();
+        this->State = STATE_AfterDelimiter;
+        return Found + this->Delimiter.size();
+    }
+
+    size_t Partial = this->partialDelimiterAt(_buffer, _size);
+    this->emitData(_buffer, Partial);
+    this->Pending.assign(_buffer + Partial, _size - Partial);
+    return _size;
+}
+
+size_t clsMultipartParser::resumePartialDelimiter(const char* _buffer, size_t _size)
+{
+    const size_t Kept = this->Pending.size();
+    const size_t Needed = this->Delimiter.size() - Kept;
+    const size_t Available = std::min(Needed, _size);
+
+    if(memcmp(_buffer, this->Delimiter.data() + Kept, Available) == 0){
+        if(Available < Needed){
+            this->Pending.append(_buffer, Available);
+            return Available;
+        }
+        this->Pending.clear();
+        if(this->State == STATE_Data)
+            this->onPartEnd();
+        this->State = STATE_AfterDelimiter;
+        return Available;
+    }
+
+    /* Kept bytes were not a delimiter. Find the first suffix of them which may still start one and report the rest as data */
+    size_t Start = 1;
+    for(; Start < Kept; ++Start){
+        size_t Remaining = Kept - Start;
+        if(memcmp(this->Pending.data() + Start, this->Delimiter.data(), Remaining) == 0 &&
+           memcmp(_buffer, this->Delimiter.data() + Remaining, std::min(this->Delimiter.size() - Remaining, _size)) == 0)
+            break;
+    }
+    this->emitData(this->Pending.data(), Start);
+    this->Pending.erase(0, Start);
+    return 0;
+}
+
+bool clsMultipartParser::parseHeaders()
+{
+    stuMultipartHeaders Headers;
+    size_t LineStart = 0;
+    while(LineStart < this->HeaderBuffer.size()){
+        size_t LineEnd = this->HeaderBuffer.find("\r\n", LineStart);
+        if(LineEnd == std::string::npos)
+            LineEnd = this->HeaderBuffer.size();
+        if(LineEnd > LineStart){
+            size_t Colon = this->HeaderBuffer.find(':', LineStart);
+            if(Colon == std::string::npos || Colon > LineEnd){
+                this->setError("Invalid multipart header: " + this->HeaderBuffer.substr(LineStart, LineEnd - LineStart));
+                return false;
+            }
+            size_t ValueStart = Colon + 1;
+            while(ValueStart < LineEnd && (this->HeaderBuffer[ValueStart] == ' ' || this->HeaderBuffer[ValueStart] == '\t'))
+                ++ValueStart;
+            Headers[toLower(this->HeaderBuffer.substr(LineStart, Colon - LineStart))] =
+                    this->HeaderBuffer.substr(ValueStart, LineEnd - ValueStart);
+        }
+        LineStart = LineEnd + 2;
+    }
+    this->HeaderBuffer.clear();
+    this->onPartBegin(Headers);
+    return true;
+}
+
+void clsMultipartParser::emitData(const char* _buffer, size_t _size)
+{
+    if(_size && this->State == STATE_Data)
+        this->onPartData(_buffer, _size);
+}
+
+void clsMultipartParser::setError(const std::string& _message)
+{
+    this->ErrorMessage = _message;
+    this->State = STATE_Error;
+}
+
+}
+}
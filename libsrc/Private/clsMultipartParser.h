@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#ifndef QHTTP_PRIVATE_CLSMULTIPARTPARSER_H
+#define QHTTP_PRIVATE_CLSMULTIPARTPARSER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace QHttp {
+namespace Private {
+
+/**
+ * @brief The stuMultipartHeaders struct holds headers of a part. Header names are stored in lower case
+ */
+struct stuMultipartHeaders : public std::map<std::string, std::string>{
+    std::string value(std::string _name) const;
+};
+
+/**
+ * @brief The clsMultipartParser class is a streaming multipart/form-data parser. Delimiters are searched by
+ *        Boyer-Moore-Horspool over the whole `CRLF--boundary` marker so part data is skipped in strides of the marker size
+ *        and reported by onPartData"()" as spans of the fed buffer without copying. Just a delimiter prefix split between two
+ *        chunks is kept internally.
+ */
+class clsMultipartParser
+{
+public:
+    clsMultipartParser(const std::string& _boundary);
+    virtual ~clsMultipartParser() {}
+
+    /**
+     * @brief feed parses next chunk of the body and returns number of consumed bytes which is less than _size just when
+     *        parsing stopped (on error or at the closing delimiter)
+     */
+    size_t feed(const char* _buffer, size_t _size);
+
+    inline bool stopped() const { return this->State == STATE_End || this->State == STATE_Error; }
+    inline bool succeeded() const { return this->State == STATE_End; }
+    inline bool hasError() const { return this->State == STATE_Error; }
+    inline const std::string& getErrorMessage() const { return this->ErrorMessage; }
+
+protected:
+    virtual void onPartBegin(const stuMultipartHeaders& _headers) = 0;
+    virtual void onPartData(const char* _buffer, size_t _size) = 0;
+    virtual void onPartEnd() = 0;
+    virtual void onEnd() = 0;
+
+private:
+    enum enuState{
+        STATE_Preamble,
+        STATE_AfterDelimiter,
+        STATE_AfterDelimiterHyphen,
+        STATE_AfterDelimiterCR,
+        STATE_Headers,
+        STATE_Data,
+        STATE_End,
+        STATE_Error,
+    };
+
+    size_t findDelimiter(const char* _buffer, size_t _size) const;
+    size_t partialDelimiterAt(const char* _buffer, size_t _size) const;
+    size_t scanBody(const char* _buffer, size_t _size);
+    size_t resumePartialDelimiter(const char* _buffer, size_t _size);
+    bool   parseHeaders();
+    void   emitData(const char* _buffer, size_t _size);
+    void   setError(const std::string& _message);
+
+private:
+    std::string Delimiter;
+    size_t      Skip[256];
+    enuState    State;
+    std::string Pending;
+    std::string HeaderBuffer;
+    std::string ErrorMessage;
+};
+
+}
+}
+
+#endif // QHTTP_PRIVATE_CLSMULTIPARTPARSER_H
@@ -0,0 +1,101 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#include <string.h>
+#include "clsPercentDecoder.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace QHttp {
+namespace Private {
+
+static inline int hexValue(char _char){
+    if(_char >= '0' && _char <= '9') return _char - '0';
+    if(_char >= 'a' && _char <= 'f') return _char - 'a' + 10;
+    if(_char >= 'A' && _char <= 'F') return _char - 'A' + 10;
+    return -1;
+}
+
+int clsPercentDecoder::find(const char* _data, int _size, bool _plusAsSpace)
+{
+    int Pos = 0;
+#ifdef __SSE2__
+    const __m128i Percent = _mm_set1_epi8('%');
+    const __m128i Plus = _mm_set1_epi8(_plusAsSpace ? '+' : '%');
+    for(; Pos + 16 <= _size; Pos += 16){
+        __m128i Chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_data + Pos));
+        int Mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(Chunk, Percent), _mm_cmpeq_epi8(Chunk, Plus)));
+        if(Mask)
+            return Pos + __builtin_ctz(static_cast<unsigned>(Mask));
+    }
+#endif
+    for(; Pos < _size; ++Pos)
+        if(_data[Pos] == '%' || (_plusAsSpace && _data[Pos] == '+'))
+            return Pos;
+    return _size;
+}
+
+int clsPercentDecoder::decodeInPlace(char* _data, int _size, bool _plusAsSpace)
+{
+    int Read = clsPercentDecoder::find(_data, _size, _plusAsSpace);
+    int Write = Read;
+    while(Read < _size){
+        if(_data[Read] == '+'){
+            _data[Write++] = ' ';
+            ++Read;
+        }else{
+            int High, Low;
+            if(Read + 2 < _size && (High = hexValue(_data[Read + 1])) >= 0 && (Low = hexValue(_data[Read + 2])) >= 0){
+                _data[Write++] = static_cast<char>((High << 4) | Low);
+                Read += 3;
+            }else
+                _data[Write++] = _data[Read++];
+        }
+
+        int Run = clsPercentDecoder::find(_data + Read, _size - Read, _plusAsSpace);
+        if(Run && Write != Read)
+            memmove(_data + Write, _data + Read, static_cast<size_t>(Run));
+        Read += Run;
+        Write += Run;
+    }
+    return Write;
+}
+
+QByteArray clsPercentDecoder::decode(const char* _data, int _size, bool _plusAsSpace)
+{
+    QByteArray Decoded(_data, _size);
+    Decoded.truncate(clsPercentDecoder::decodeInPlace(Decoded.data(), Decoded.size(), _plusAsSpace));
+    return Decoded;
+}
+
+QString clsPercentDecoder::decodeToString(const char* _data, int _size, bool _plusAsSpace)
+{
+    if(clsPercentDecoder::needsDecode(_data, _size, _plusAsSpace) == false)
+        return QString::fromUtf8(_data, _size);
+    return QString::fromUtf8(clsPercentDecoder::decode(_data, _size, _plusAsSpace));
+}
+
+}
+}
@@ -0,0 +1,68 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#ifndef QHTTP_PRIVATE_CLSPERCENTDECODER_H
+#define QHTTP_PRIVATE_CLSPERCENTDECODER_H
+
+#include <QByteArray>
+#include <QString>
+
+namespace QHttp {
+namespace Private {
+
+/**
+ * @brief The clsPercentDecoder class decodes percent-encoded (and optionally `+` as space) byte spans in place. Bytes
+ *        which need no decoding are skipped 16 at a time using SSE2 when available and moved as whole runs, so values
+ *        without `%` nor `+` are detected by a single scan and returned untouched. Malformed escapes are kept verbatim
+ *        as QByteArray::fromPercentEncoding does.
+ */
+class clsPercentDecoder
+{
+public:
+    /**
+     * @brief find returns position of first byte needing decode in [_data, _data + _size) or _size when there is none
+     */
+    static int find(const char* _data, int _size, bool _plusAsSpace);
+    static inline bool needsDecode(const char* _data, int _size, bool _plusAsSpace) {
+        return clsPercentDecoder::find(_data, _size, _plusAsSpace) < _size;
+    }
+
+    /**
+     * @brief decodeInPlace decodes _size bytes of _data in place and returns the decoded size
+     */
+    static int decodeInPlace(char* _data, int _size, bool _plusAsSpace);
+
+    static QByteArray decode(const char* _data, int _size, bool _plusAsSpace);
+    static QString decodeToString(const char* _data, int _size, bool _plusAsSpace);
+    static inline QString decodeToString(const QString& _value, bool _plusAsSpace){
+        if(_value.indexOf('%') < 0 && (_plusAsSpace == false || _value.indexOf('+') < 0))
+            return _value;
+        QByteArray Value = _value.toUtf8();
+        return clsPercentDecoder::decodeToString(Value.constData(), Value.size(), _plusAsSpace);
+    }
+};
+
+}
+}
+
+#endif // QHTTP_PRIVATE_CLSPERCENTDECODER_H
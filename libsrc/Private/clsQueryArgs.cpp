@@ -0,0 +1,152 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#include <algorithm>
+#include <string.h>
+#include "clsQueryArgs.h"
+#include "clsPercentDecoder.h"
+
+namespace QHttp {
+namespace Private {
+
+clsQueryArgs::clsQueryArgs(const QByteArray& _query) :
+    Raw(_query)
+{
+    const char* Data = this->Raw.constData();
+    const int   Size = this->Raw.size();
+
+    for(int Start = 0; Start < Size; ){
+        const char* End = static_cast<const char*>(memchr(Data + Start, '&', static_cast<size_t>(Size - Start)));
+        int Length = (End ? static_cast<int>(End - Data) : Size) - Start;
+        if(Length > 0){
+            const char* Equal = static_cast<const char*>(memchr(Data + Start, '=', static_cast<size_t>(Length)));
+            stuEntry Entry;
+            Entry.Flags = 0;
+            Entry.NameOffset = Start;
+            Entry.NameLength = Equal ? static_cast<int>(Equal - Data) - Start : Length;
+            Entry.ValueOffset = Equal ? static_cast<int>(Equal - Data) + 1 : Start + Length;
+            Entry.ValueLength = Equal ? Start + Length - Entry.ValueOffset : -1;
+
+            if(clsPercentDecoder::needsDecode(Data + Entry.NameOffset, Entry.NameLength, true)){
+                QByteArray Name = clsPercentDecoder::decode(Data + Entry.NameOffset, Entry.NameLength, true);
+                Entry.NameOffset = this->Owned.size();
+                Entry.NameLength = Name.size();
+                Entry.Flags |= FLAG_NameOwned;
+                this->Owned.append(Name);
+            }
+            if(Entry.ValueLength > 0 && clsPercentDecoder::needsDecode(Data + Entry.ValueOffset, Entry.ValueLength, true))
+                Entry.Flags |= FLAG_ValueEncoded;
+
+            Entry.Hash = clsQueryArgs::hash(this->nameData(Entry), Entry.NameLength);
+            this->addEntry(Entry);
+        }
+        Start += Length + 1;
+    }
+}
+
+void clsQueryArgs::append(const QString& _name, const QString& _value)
+{
+    QByteArray Name = _name.toUtf8();
+    QByteArray Value = _value.toUtf8();
+
+    stuEntry Entry;
+    Entry.Flags = FLAG_NameOwned | FLAG_ValueOwned;
+    Entry.Hash = clsQueryArgs::hash(Name);
+    Entry.NameOffset = this->Owned.size();
+    Entry.NameLength = Name.size();
+    this->Owned.append(Name);
+    Entry.ValueOffset = this->Owned.size();
+    Entry.ValueLength = Value.size();
+    this->Owned.append(Value);
+    this->addEntry(Entry);
+}
+
+int clsQueryArgs::indexOf(const QByteArray& _name, uint _hash) const
+{
+    if(this->Slots.isEmpty())
+        return -1;
+
+    int Mask = this->Slots.size() - 1;
+    for(int Slot = static_cast<int>(_hash) & Mask; this->Slots.at(Slot) >= 0; Slot = (Slot + 1) & Mask){
+        const stuEntry& Entry = this->Entries.at(this->Slots.at(Slot));
+        if(Entry.Hash == _hash &&
+           Entry.NameLength == _name.size() &&
+           memcmp(this->nameData(Entry), _name.constData(), static_cast<size_t>(Entry.NameLength)) == 0)
+            return this->Slots.at(Slot);
+    }
+    return -1;
+}
+
+QString clsQueryArgs::name(int _index) const
+{
+    const stuEntry& Entry = this->Entries.at(_index);
+    return QString::fromUtf8(this->nameData(Entry), Entry.NameLength);
+}
+
+QString clsQueryArgs::value(int _index) const
+{
+    const stuEntry& Entry = this->Entries.at(_index);
+    if(Entry.ValueLength <= 0)
+        return QString();
+    if(Entry.Flags & FLAG_ValueEncoded)
+        return QString::fromUtf8(clsPercentDecoder::decode(this->valueData(Entry), Entry.ValueLength, true));
+    return QString::fromUtf8(this->valueData(Entry), Entry.ValueLength);
+}
+
+void clsQueryArgs::addEntry(const stuEntry& _entry)
+{
+    if(this->Entries.size() >= 0x7FFF)
+        return;
+
+    this->Entries.append(_entry);
+    if(this->Entries.size() * 2 > this->Slots.size()){
+        int Capacity = 16;
+        while(Capacity < this->Entries.size() * 2)
+            Capacity <<= 1;
+        this->Slots.resize(Capacity);
+        std::fill(this->Slots.begin(), this->Slots.end(), static_cast<qint16>(-1));
+        for(int i = 0; i < this->Entries.size(); ++i)
+            this->index(i);
+    }else
+        this->index(this->Entries.size() - 1);
+}
+
+void clsQueryArgs::index(int _entryIndex)
+{
+    const stuEntry& Entry = this->Entries.at(_entryIndex);
+    /* Arguments without value and repeated names are not indexed so the first occurrence is always bound */
+    if(Entry.ValueLength < 0)
+        return;
+    QByteArray Name = QByteArray::fromRawData(this->nameData(Entry), Entry.NameLength);
+    if(this->indexOf(Name, Entry.Hash) >= 0)
+        return;
+
+    int Mask = this->Slots.size() - 1;
+    int Slot = static_cast<int>(Entry.Hash) & Mask;
+    while(this->Slots.at(Slot) >= 0)
+        Slot = (Slot + 1) & Mask;
+    this->Slots[Slot] = static_cast<qint16>(_entryIndex);
+}
+
+}
+}
@@ -0,0 +1,96 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#ifndef QHTTP_PRIVATE_CLSQUERYARGS_H
+#define QHTTP_PRIVATE_CLSQUERYARGS_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVarLengthArray>
+
+namespace QHttp {
+namespace Private {
+
+/**
+ * @brief The clsQueryArgs class parses a raw (percent-encoded) query string in a single pass. Arguments are kept as
+ *        offsets on the raw bytes and indexed by an open-addressing table keyed by name hash so binding a parameter is a
+ *        single probe. Values are decoded only when they are requested.
+ */
+class clsQueryArgs
+{
+public:
+    clsQueryArgs() {}
+    explicit clsQueryArgs(const QByteArray& _query);
+
+    void append(const QString& _name, const QString& _value);
+
+    inline int size() const { return this->Entries.size(); }
+    int indexOf(const QByteArray& _name, uint _hash) const;
+    QString name(int _index) const;
+    QString value(int _index) const;
+    inline bool hasValue(int _index) const { return this->Entries.at(_index).ValueLength >= 0; }
+
+    static inline uint hash(const char* _data, int _size){
+        uint Hash = 2166136261u;
+        for(int i = 0; i < _size; ++i)
+            Hash = (Hash ^ static_cast<quint8>(_data[i])) * 16777619u;
+        return Hash;
+    }
+    static inline uint hash(const QByteArray& _data) { return clsQueryArgs::hash(_data.constData(), _data.size()); }
+
+private:
+    enum enuFlags : quint8 {
+        FLAG_NameOwned    = 0x01,
+        FLAG_ValueOwned   = 0x02,
+        FLAG_ValueEncoded = 0x04,
+    };
+
+    struct stuEntry{
+        uint   Hash;
+        int    NameOffset;
+        int    NameLength;
+        int    ValueOffset;
+        int    ValueLength;
+        quint8 Flags;
+    };
+
+    inline const char* nameData(const stuEntry& _entry) const {
+        return (_entry.Flags & FLAG_NameOwned ? this->Owned : this->Raw).constData() + _entry.NameOffset;
+    }
+    inline const char* valueData(const stuEntry& _entry) const {
+        return (_entry.Flags & FLAG_ValueOwned ? this->Owned : this->Raw).constData() + _entry.ValueOffset;
+    }
+    void addEntry(const stuEntry& _entry);
+    void index(int _entryIndex);
+
+private:
+    QByteArray                      Raw;
+    QByteArray                      Owned;
+    QVarLengthArray<stuEntry, 16>   Entries;
+    QVarLengthArray<qint16, 32>     Slots;
+};
+
+}
+}
+
+#endif // QHTTP_PRIVATE_CLSQUERYARGS_H
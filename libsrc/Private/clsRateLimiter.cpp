@@ -0,0 +1,150 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#include <chrono>
+#include <string.h>
+#include <QRandomGenerator>
+#include <QtEndian>
+#include "clsRateLimiter.h"
+
+namespace QHttp {
+namespace Private {
+
+static constexpr quint64 TIME_BITS       = 36;
+static constexpr quint64 TOKEN_BITS      = 16;
+static constexpr quint64 TIME_MASK       = (1ull << TIME_BITS) - 1;
+static constexpr quint64 TOKEN_MASK      = (1ull << TOKEN_BITS) - 1;
+static constexpr quint64 TOKEN_SCALE     = 16;
+static constexpr quint64 MAX_RATE        = TOKEN_MASK / TOKEN_SCALE;
+
+clsRateLimiter::stuShard clsRateLimiter::Shards[clsRateLimiter::SHARDS_COUNT];
+
+static inline quint64 rotl64(quint64 _value, int _bits){
+    return (_value << _bits) | (_value >> (64 - _bits));
+}
+
+#define SIP_ROUND(_v0, _v1, _v2, _v3) \
+    _v0 += _v1; _v1 = rotl64(_v1, 13); _v1 ^= _v0; _v0 = rotl64(_v0, 32); \
+    _v2 += _v3; _v3 = rotl64(_v3, 16); _v3 ^= _v2; \
+    _v0 += _v3; _v3 = rotl64(_v3, 21); _v3 ^= _v0; \
+    _v2 += _v1; _v1 = rotl64(_v1, 17); _v1 ^= _v2; _v2 = rotl64(_v2, 32)
+
+/**
+ * Keys are SipHash-2-4 of data keyed by a per-process random secret so that clients can not compute which addresses
+ * share a bucket with (and so can drain tokens of) another client.
+ */
+quint64 clsRateLimiter::makeKey(const quint8* _data, size_t _size, quint64 _salt)
+{
+    static const quint64 Secret[2] = { QRandomGenerator::system()->generate64(), QRandomGenerator::system()->generate64() };
+
+    quint64 V0 = 0x736f6d6570736575ull ^ Secret[0];
+    quint64 V1 = 0x646f72616e646f6dull ^ Secret[1] ^ _salt;
+    quint64 V2 = 0x6c7967656e657261ull ^ Secret[0];
+    quint64 V3 = 0x7465646279746573ull ^ Secret[1];
+
+    size_t Pos = 0;
+    for(; Pos + 8 <= _size; Pos += 8){
+        quint64 Word;
+        memcpy(&Word, _data + Pos, 8);
+        Word = qFromLittleEndian(Word);
+        V3 ^= Word;
+        SIP_ROUND(V0, V1, V2, V3);
+        SIP_ROUND(V0, V1, V2, V3);
+        V0 ^= Word;
+    }
+    quint64 Last = static_cast<quint64>(_size) << 56;
+    for(size_t i = 0; Pos + i < _size; ++i)
+        Last |= static_cast<quint64>(_data[Pos + i]) << (8 * i);
+    V3 ^= Last;
+    SIP_ROUND(V0, V1, V2, V3);
+    SIP_ROUND(V0, V1, V2, V3);
+    V0 ^= Last;
+
+    V2 ^= 0xff;
+    for(int i = 0; i < 4; ++i){
+        SIP_ROUND(V0, V1, V2, V3);
+    }
+    return V0 ^ V1 ^ V2 ^ V3;
+}
+
+bool clsRateLimiter::allow(quint64 _key, quint32 _ratePerSecond)
+{
+    if(_ratePerSecond == 0)
+        return true;
+
+    quint64 Rate = qMin(static_cast<quint64>(_ratePerSecond), MAX_RATE);
+    quint64 Burst = Rate * TOKEN_SCALE;
+    quint64 Fingerprint = (_key >> (TIME_BITS + TOKEN_BITS)) | 1;
+    quint64 Now = static_cast<quint64>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                           std::chrono::steady_clock::now().time_since_epoch()).count()) & TIME_MASK;
+
+    /* Each key may live on one of two slots of its shard. When the key owns neither, the slot which has been idle longer
+       (an empty one first) is taken over and starts from a full burst */
+    stuShard& Shard = clsRateLimiter::Shards[_key % SHARDS_COUNT];
+    std::atomic<quint64>* Slots[2] = {
+        &Shard.Buckets[(_key >> 6) % SLOTS_PER_SHARD],
+        &Shard.Buckets[(_key >> 18) % SLOTS_PER_SHARD]
+    };
+    auto fingerprintOf = [](quint64 _bucket) { return _bucket >> (TIME_BITS + TOKEN_BITS); };
+    auto idleTime = [Now](quint64 _bucket) { return _bucket ? (Now - (_bucket & TIME_MASK)) & TIME_MASK : TIME_MASK; };
+
+    std::atomic<quint64>* Bucket;
+    quint64 Current;
+    quint64 First = Slots[0]->load(std::memory_order_relaxed);
+    quint64 Second = Slots[1]->load(std::memory_order_relaxed);
+    if(fingerprintOf(First) == Fingerprint)
+        Bucket = Slots[0], Current = First;
+    else if(fingerprintOf(Second) == Fingerprint)
+        Bucket = Slots[1], Current = Second;
+    else if(idleTime(First) >= idleTime(Second))
+        Bucket = Slots[0], Current = First;
+    else
+        Bucket = Slots[1], Current = Second;
+
+    forever{
+        quint64 Tokens = Burst;
+        quint64 RefillTime = Now;
+        if(Current && fingerprintOf(Current) == Fingerprint){
+            RefillTime = Current & TIME_MASK;
+            quint64 Elapsed = (Now - RefillTime) & TIME_MASK;
+            quint64 Gained = Elapsed * Rate * TOKEN_SCALE / 1000;
+            Tokens = qMin(((Current >> TIME_BITS) & TOKEN_MASK), Burst) + Gained;
+            /// Just advance refill time by the time which has been converted to tokens so that fractions are not lost
+            if(Tokens >= Burst){
+                Tokens = Burst;
+                RefillTime = Now;
+            }else{
+                RefillTime = (RefillTime + Gained * 1000 / (Rate * TOKEN_SCALE)) & TIME_MASK;
+            }
+        }
+
+        if(Tokens < TOKEN_SCALE)
+            return false;
+
+        quint64 Updated = (Fingerprint << (TIME_BITS + TOKEN_BITS)) | ((Tokens - TOKEN_SCALE) << TIME_BITS) | RefillTime;
+        if(Bucket->compare_exchange_weak(Current, Updated, std::memory_order_relaxed))
+            return true;
+    }
+}
+}
+}
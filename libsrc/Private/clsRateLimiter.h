@@ -0,0 +1,59 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#ifndef QHTTP_PRIVATE_CLSRATELIMITER_H
+#define QHTTP_PRIVATE_CLSRATELIMITER_H
+
+#include <atomic>
+#include <QtGlobal>
+
+namespace QHttp {
+namespace Private {
+
+/**
+ * @brief The clsRateLimiter class is a lock-free token bucket table. Buckets are addressed by a 64bit keyed hash (e.g. of
+ *        client IP and route) and packed in a single atomic word so checking a request needs no lock and no allocation.
+ *        Each bucket word is: [12bits key fingerprint][16bits tokens in 1/16 units][36bits last refill time in ms]
+ *        Each key may be stored on two slots and fingerprints tell which one (if any) belongs to it.
+ */
+class clsRateLimiter
+{
+public:
+    static bool allow(quint64 _key, quint32 _ratePerSecond);
+    static quint64 makeKey(const quint8* _data, size_t _size, quint64 _salt);
+
+private:
+    static constexpr quint32 SHARDS_COUNT    = 64;
+    static constexpr quint32 SLOTS_PER_SHARD = 4096;
+
+    struct alignas(64) stuShard{
+        std::atomic<quint64> Buckets[SLOTS_PER_SHARD];
+    };
+
+    static stuShard Shards[SHARDS_COUNT];
+};
+
+}
+}
+
+#endif // QHTTP_PRIVATE_CLSRATELIMITER_H
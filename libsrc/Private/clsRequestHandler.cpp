@@ -25,124 +25,407 @@
 #include <QJsonObject>
 #include <QJsonDocument>
 #include <map>
+#include <ctype.h>
+#include <string.h>
 #include <utility>
 #include <QTcpSocket>
+#include <QTimer>
+#include <sys/socket.h>
+#include <QCoreApplication>
+#include <QElapsedTimer>
 #include "QFieldValidator.h"
 #include "clsRequestHandler.h"
 #include "libTargomanCommon/CmdIO.h"
 #include "intfRESTAPIHolder.h"
 #include "Configs.hpp"
 #include "QJWT.h"
+#include "clsRateLimiter.h"
+#include "clsJSONEngine.h"
 
 namespace QHttp {
 namespace Private {
 
 stuConfigs gConfigs;
 stuStatistics gServerStats;
+QMutex gServerStatsLock;
 
 using namespace qhttp::server;
 using namespace Targoman::Common;
 
+QScopedPointer<clsAPIExecutor> clsRequestHandler::APIExecutor;
+QAtomicInt clsRequestHandler::InFlightRequests;
+
+/**
+ * @brief The clsAPIInvocation class invokes an API on worker threads and posts its result or error back to the
+ *        request handler which lives on the IO thread owning the connection
+ */
+class clsAPIInvocation : public QRunnable{
+public:
+    clsAPIInvocation(QObject* _requestHandler, qhttp::TStatusCode _code, const std::function<QVariant()>& _invoker) :
+        RequestHandler(_requestHandler),
+        StatusCode(_code),
+        Invoker(_invoker),
+        OnShed([_requestHandler](){ QCoreApplication::postEvent(_requestHandler, clsAPIInvocation::makeShedEvent()); })
+    {
+        this->QueueTimer.start();
+    }
+    clsAPIInvocation(const std::function<void()>& _asyncInvoker, const std::function<void()>& _onShed) :
+        RequestHandler(nullptr),
+        StatusCode(qhttp::ESTATUS_OK),
+        AsyncInvoker(_asyncInvoker),
+        OnShed(_onShed)
+    {
+        this->QueueTimer.start();
+    }
+
+    static clsAPIResultEvent* makeShedEvent(){
+        clsAPIResultEvent* ShedEvent = new clsAPIResultEvent(qhttp::ESTATUS_SERVICE_UNAVAILABLE, "Server is overloaded", false);
+        ShedEvent->Shed = true;
+        return ShedEvent;
+    }
+
+    void run() Q_DECL_FINAL{
+        if(gConfigs.Public.MaxQueueTimeMSecs && this->QueueTimer.elapsed() > gConfigs.Public.MaxQueueTimeMSecs)
+            return this->OnShed();
+
+        if(this->AsyncInvoker)
+            return this->AsyncInvoker();
+
+        clsAPIResultEvent* ResultEvent;
+        try{
+            ResultEvent = new clsAPIResultEvent(this->StatusCode, this->Invoker());
+        }catch(exTargomanBase& ex){
+            ResultEvent = new clsAPIResultEvent(static_cast<qhttp::TStatusCode>(ex.httpCode()), ex.what(), ex.httpCode() >= 500);
+        }catch(QFieldValidator::exRequiredParam &ex){
+            ResultEvent = new clsAPIResultEvent(qhttp::ESTATUS_BAD_REQUEST, ex.what(), false);
+        }catch(QFieldValidator::exInvalidValue &ex){
+            ResultEvent = new clsAPIResultEvent(qhttp::ESTATUS_BAD_REQUEST, ex.what(), false);
+        }catch(std::exception &ex){
+            ResultEvent = new clsAPIResultEvent(qhttp::ESTATUS_INTERNAL_SERVER_ERROR, ex.what(), true);
+        }
+        QCoreApplication::postEvent(this->RequestHandler, ResultEvent);
+    }
+
+private:
+    QObject*                  RequestHandler;
+    qhttp::TStatusCode        StatusCode;
+    std::function<QVariant()> Invoker;
+    std::function<void()>     AsyncInvoker;
+    std::function<void()>     OnShed;
+    QElapsedTimer             QueueTimer;
+};
+
+stuAsyncResponseState::~stuAsyncResponseState()
+{
+    this->post(new clsAPIResultEvent(qhttp::ESTATUS_INTERNAL_SERVER_ERROR, "Async API finished without any response", true));
+}
+
+void stuAsyncResponseState::post(clsAPIResultEvent* _event)
+{
+    if(this->Delivered.testAndSetOrdered(0, 1))
+        QCoreApplication::postEvent(this->RequestHandler, _event);
+    else
+        delete _event;
+}
+
+void clsRequestHandler::startAPIWorkers(quint16 _count)
+{
+    if(_count == 0)
+        return;
+    clsRequestHandler::APIExecutor.reset(new clsAPIExecutor(_count));
+}
+
+void clsRequestHandler::stopAPIWorkers()
+{
+    if(clsRequestHandler::APIExecutor.isNull())
+        return;
+    clsRequestHandler::APIExecutor->waitForDone();
+    clsRequestHandler::APIExecutor.reset();
+}
+
+quint32 clsRequestHandler::inFlightRequests()
+{
+    return static_cast<quint32>(clsRequestHandler::InFlightRequests.load());
+}
+
+QHash<QByteArray, stuQueueStatistics> clsRequestHandler::apiQueueStats()
+{
+    if(clsRequestHandler::APIExecutor.isNull())
+        return {};
+    return clsRequestHandler::APIExecutor->queueStats();
+}
+
 clsRequestHandler::clsRequestHandler(QHttpRequest *_req, QHttpResponse *_res, QObject* _parent) :
     QObject(_parent),
     Request(_req),
     Response(_res)
-{}
+{
+    /* Requests are destroyed by qhttp when the client disconnects, which may happen before any response is sent */
+    QObject::connect(_req, &QObject::destroyed, this, [this](){
+        this->onRequestDestroyed();
+    });
+}
+
+clsRequestHandler::~clsRequestHandler()
+{
+    /* APIs still reading the body must not wait for data which will never be delivered to this handler */
+    if(this->BodyStream){
+        this->BodyStream->abort("Request was finished before body was consumed");
+        this->resumeReading();
+    }
+    if(this->BodyEnded == false && this->Request){
+        this->Request->onData(nullptr);
+        this->Request->onEnd(nullptr);
+    }
+    this->releaseAdmission();
+}
+
+/**
+ * Body handlers are detached when the response is sent before the body is received. It is deferred as it may be called
+ * from inside the body handlers themselves, which meanwhile return early as the response is sent.
+ */
+void clsRequestHandler::detachBody()
+{
+    if(this->BodyEnded || this->Request.isNull())
+        return;
+    if(this->BodyStream)
+        this->BodyStream->abort("Response was sent before body was received");
+    QTimer::singleShot(0, this, [this](){
+        if(this->BodyEnded == false && this->Request){
+            this->Request->onData(nullptr);
+            this->Request->onEnd(nullptr);
+            this->BodyEnded = true;
+        }
+    });
+}
+
+void clsRequestHandler::releaseAdmission()
+{
+    if(this->CountedInFlight){
+        this->CountedInFlight = false;
+        clsRequestHandler::InFlightRequests.fetchAndSubOrdered(1);
+    }
+    if(this->AcquiredAPISlot){
+        this->AcquiredAPISlot = false;
+        this->APIObject->releaseSlot();
+    }
+}
+
+/**
+ * Admission is released as soon as the response is sent (or the client is gone) while the handler itself is kept alive
+ * until pending API results, which refer to it, are delivered.
+ */
+void clsRequestHandler::finish()
+{
+    this->releaseAdmission();
+    if(this->ResultPending == false)
+        this->deleteLater();
+}
+
+void clsRequestHandler::onRequestDestroyed()
+{
+    /* APIs blocked on body would wait forever as the connection is gone */
+    if(this->BodyStream)
+        this->BodyStream->abort("Client disconnected before request body was received");
+    /* Handler may be kept for pending results so spools of an aborted upload must not wait for its deletion */
+    this->MultipartFormDataHandler.reset();
+    this->finish();
+}
+
+void clsRequestHandler::resolveAPI(const QString& _api)
+{
+    this->APIObject = RESTAPIRegistry::getAPIObject(this->Request->method(), _api, &this->ExtraAPIPath, &this->PathArgs);
+}
+
+bool clsRequestHandler::admit()
+{
+    this->CountedInFlight = true;
+    quint32 InFlight = static_cast<quint32>(clsRequestHandler::InFlightRequests.fetchAndAddOrdered(1));
+    if(gConfigs.Public.MaxInFlightRequests && InFlight >= gConfigs.Public.MaxInFlightRequests)
+        return false;
+
+    if(this->APIObject && gConfigs.Public.MaxInFlightPerAPI){
+        this->AcquiredAPISlot = true;
+        if(this->APIObject->acquireSlot() >= gConfigs.Public.MaxInFlightPerAPI)
+            return false;
+    }
+    return true;
+}
+
+bool clsRequestHandler::isRateLimited(const QString& _api)
+{
+    if(gConfigs.Public.RateLimitPerIP == 0 &&
+       gConfigs.Public.RateLimitPerIPRoute == 0 &&
+       gConfigs.Public.RateLimitPerConnection == 0)
+        return false;
+
+    enum enuKeySalt : quint64 {
+        SALT_IP         = 1,
+        SALT_Connection = 2
+    };
+
+    QTcpSocket* Socket = this->Request->connection()->tcpSocket();
+    bool IsIPv4 = false;
+    Socket->peerAddress().toIPv4Address(&IsIPv4);
+    Q_IPV6ADDR PeerAddress = Socket->peerAddress().toIPv6Address();
+    /* IPv6 clients own whole /64 prefixes so they can not escape limits by rotating addresses */
+    quint64 IPKey = clsRateLimiter::makeKey(PeerAddress.c, IsIPv4 ? sizeof(PeerAddress.c) : 8, SALT_IP);
+
+    if(clsRateLimiter::allow(IPKey, gConfigs.Public.RateLimitPerIP) == false)
+        return true;
+
+    if(gConfigs.Public.RateLimitPerIPRoute){
+        quint64 Route = this->APIObject ? reinterpret_cast<quintptr>(this->APIObject) : qHash(_api);
+        if(clsRateLimiter::allow(IPKey ^ clsRateLimiter::makeKey(reinterpret_cast<const quint8*>(&Route), sizeof(Route), SALT_IP),
+                                 gConfigs.Public.RateLimitPerIPRoute) == false)
+            return true;
+    }
+
+    if(gConfigs.Public.RateLimitPerConnection){
+        quint64 ConnectionID = reinterpret_cast<quintptr>(this->Request->connection()) ^ (static_cast<quint64>(Socket->peerPort()) << 48);
+        if(clsRateLimiter::allow(clsRateLimiter::makeKey(reinterpret_cast<const quint8*>(&ConnectionID), sizeof(ConnectionID), SALT_Connection),
+                                 gConfigs.Public.RateLimitPerConnection) == false)
+            return true;
+    }
+
+    return false;
+}
+
+static constexpr char APPLICATION_JSON_HEADER[] = "application/json";
+static constexpr char APPLICATION_FORM_HEADER[] = "application/x-www-form-urlencoded";
+static constexpr char MULTIPART_BOUNDARY_HEADER[] = "multipart/form-data; boundary=";
+static constexpr int  PAUSE_PROBE_INTERVAL_MSECS = 1000;
+
+/**
+ * Validates body related headers before any byte of the body is read so invalid or oversized requests are rejected early.
+ * Clients waiting on `Expect: 100-continue` are allowed to send the body only when all checks pass.
+ */
+void clsRequestHandler::validateRequestHeaders()
+{
+    const qhttp::THeaderHash& Headers = this->Request->headers();
+    QByteArray ContentLengthStr = Headers.value("content-length");
+    QByteArray TransferEncoding = Headers.value("transfer-encoding").toLower();
+
+    if(ContentLengthStr.isEmpty() && TransferEncoding.isEmpty())
+        return;
+
+    switch(this->Request->method()){
+    case qhttp::EHTTP_POST:
+    case qhttp::EHTTP_PUT:
+    case qhttp::EHTTP_PATCH:
+        break;
+    default:
+        /* Clients may send an explicit zero length on bodyless methods */
+        if(TransferEncoding.isEmpty() && ContentLengthStr.trimmed() == "0")
+            return;
+        throw exHTTPBadRequest("Method: "+this->Request->methodString()+" is not supported or does not accept request body");
+    }
+
+    this->MaxBodySize = this->APIObject && this->APIObject->maxBodySize() ? this->APIObject->maxBodySize() : gConfigs.Public.MaxUploadSize;
+
+    /* Size of chunked bodies is unknown so it is checked while chunks are received */
+    if(ContentLengthStr.isEmpty()){
+        if(TransferEncoding.endsWith("chunked") == false)
+            throw exHTTPLengthRequired("No content-length header present");
+    }else{
+        bool Ok = false;
+        this->ContentLength = ContentLengthStr.toLongLong(&Ok);
+        if(Ok == false || this->ContentLength < 0)
+            throw exHTTPBadRequest("Invalid content-length: " + ContentLengthStr);
+        if(this->ContentLength == 0)
+            return;
+        if(this->ContentLength > this->MaxBodySize)
+            throw exHTTPPayloadTooLarge(QString("Content-Size is too large: %1 > %2").arg(this->ContentLength).arg(this->MaxBodySize));
+    }
+
+    this->ContentType = Headers.value("content-type");
+    /* Body of streaming APIs is passed as is so any content type is accepted */
+    if(this->APIObject == nullptr || this->APIObject->requiresBodyStream() == false){
+        if(this->ContentType.isEmpty())
+            throw exHTTPBadRequest("No content-type header present");
+        if(this->ContentType != APPLICATION_JSON_HEADER &&
+           this->ContentType != APPLICATION_FORM_HEADER &&
+           this->ContentType.startsWith(MULTIPART_BOUNDARY_HEADER) == false)
+            throw exHTTPUnsupportedMediaType(("unsupported Content-Type: " + this->ContentType).constData());
+    }
+
+    if(Headers.value("expect").toLower() == "100-continue")
+        this->Request->connection()->tcpSocket()->write("HTTP/1.1 100 Continue\r\n\r\n");
+}
 
 void clsRequestHandler::process(const QString& _api) {
+    if(this->Request->method() != qhttp::EHTTP_OPTIONS)
+        this->resolveAPI(_api);
+
+    if(this->isRateLimited(_api))
+        return this->sendRateLimitedResponse();
+
+    if(this->admit() == false)
+        return this->sendShedResponse();
+
+    try{
+        this->validateRequestHeaders();
+    }catch(exTargomanBase& ex){
+        /* Body (if any) will not be read so connection must be closed */
+        return this->sendError(static_cast<qhttp::TStatusCode>(ex.httpCode()), ex.what(), true);
+    }
+
+    /* APIs able to consume body without blocking the IO thread are invoked before the body arrives */
+    bool InvokeBeforeBody = false;
+    if(this->APIObject && this->APIObject->requiresBodyStream()){
+        InvokeBeforeBody = clsRequestHandler::APIExecutor.isNull() == false || this->APIObject->isAsync();
+        this->BodyStream = QSharedPointer<clsBodyStream>(
+                               new clsBodyStream(InvokeBeforeBody ? gConfigs.Public.BodyStreamBufferSize : 0),
+                               &QObject::deleteLater);
+        QObject::connect(this->BodyStream.data(), &clsBodyStream::sigDrained, this, [this](){
+            this->resumeReading();
+        }, Qt::QueuedConnection);
+    }
+
     this->Request->onData([this](QByteArray _data){
+        /* Rest of the body of a request which is already responded (e.g. by an error) is discarded */
+        if(this->ResponseSent)
+            return;
         try{
-            QByteArray ContentType= this->Request->headers().value("content-type");
-            if(ContentType.isEmpty())
-                throw exHTTPBadRequest("No content-type header present");
-            QByteArray ContentLengthStr = this->Request->headers().value("content-length");
-            if(ContentLengthStr.isEmpty())
-                throw exHTTPBadRequest("No content-length header present");
-
-            qlonglong ContentLength = ContentLengthStr.toLongLong ();
-            if(!ContentLength)
-                throw exHTTPLengthRequired("content-length seems to be zero");
-            if(ContentLength > gConfigs.Public.MaxUploadSize)
-                throw exHTTPPayloadTooLarge(QString("Content-Size is too large: %d").arg(ContentLength));
-
-            switch(this->Request->method()){
-            case qhttp::EHTTP_POST:
-            case qhttp::EHTTP_PUT:
-            case qhttp::EHTTP_PATCH:
-                break;
-            default:
-                throw exHTTPBadRequest("Method: "+this->Request->methodString()+" is not supported or does not accept request body");
+            this->ReceivedBytes += _data.size();
+            if(this->ContentLength < 0 && this->ReceivedBytes > this->MaxBodySize)
+                throw exHTTPPayloadTooLarge(QString("Request body is too large: %1 > %2").arg(this->ReceivedBytes).arg(this->MaxBodySize));
+
+            if(this->BodyStream){
+                if(this->BodyStream->append(_data) == false)
+                    this->pauseReading();
+                return;
             }
-            static constexpr char APPLICATION_JSON_HEADER[] = "application/json";
-            static constexpr char APPLICATION_FORM_HEADER[] = "application/x-www-form-urlencoded";
-            static constexpr char MULTIPART_BOUNDARY_HEADER[] = "multipart/form-data; boundary=";
+
+            if(this->ContentLength == 0 || this->ContentType.isEmpty())
+                throw exHTTPLengthRequired("No content-length header present");
+            const QByteArray& ContentType = this->ContentType;
+            const qlonglong   ContentLength = this->ContentLength;
 
             switch(ContentType.at(0)){
             case 'a':{
-                if(ContentType != APPLICATION_JSON_HEADER && ContentType != APPLICATION_FORM_HEADER)
-                    throw exHTTPBadRequest(("unsupported Content-Type: " + ContentType).constData());
-
-                if(_data.size() == ContentLength){
+                /* Chunked bodies are parsed when all chunks are received */
+                if(ContentLength < 0){
+                    this->RemainingData.append(_data);
+                    break;
+                }
+                /* Single chunk bodies are used as is and others are collected on a buffer reserved once */
+                if(this->RemainingData.isEmpty() && _data.size() == ContentLength){
                     this->RemainingData = _data;
-                }else if (this->RemainingData.size()){
-                    this->RemainingData += _data;
+                }else{
+                    if(this->RemainingData.isEmpty())
+                        this->RemainingData.reserve(static_cast<int>(ContentLength));
+                    this->RemainingData.append(_data);
                     if(this->RemainingData.size() < ContentLength)
                         return;
-                }else{
-                    this->RemainingData = _data;
-                    return;
-                }
-
-                this->RemainingData = this->RemainingData.trimmed();
-
-                if(this->RemainingData.startsWith('{') || this->RemainingData.startsWith('[')){
-                    if(this->RemainingData.startsWith('{') == false || this->RemainingData.endsWith('}') == false)
-                        throw exHTTPBadRequest("Invalid JSON Object");
-                    QJsonParseError Error;
-                    QJsonDocument JSON = QJsonDocument::fromJson(this->RemainingData, &Error);
-                    if(JSON.isNull() || JSON.isObject() == false)
-                        throw exHTTPBadRequest(QString("Invalid JSON Object: %1").arg(Error.errorString()));
-                    QJsonObject JSONObject = JSON.object();
-                    for(auto JSONObjectIter = JSONObject.begin();
-                        JSONObjectIter != JSONObject.end();
-                        ++JSONObjectIter){
-                        if(JSONObjectIter.value().isBool())
-                            this->Request->addUserDefinedData(JSONObjectIter.key(), JSONObjectIter.value().toBool() ? "1" : "0");
-                        else if(JSONObjectIter.value().isNull())
-                            this->Request->addUserDefinedData(JSONObjectIter.key(), QString());
-                        else if(JSONObjectIter.value().isArray())
-                            this->Request->addUserDefinedData(JSONObjectIter.key(), QJsonDocument(JSONObjectIter.value().toArray()).toJson());
-                        else if(JSONObjectIter.value().isObject())
-                            this->Request->addUserDefinedData(JSONObjectIter.key(), QJsonDocument(JSONObjectIter.value().toObject()).toJson());
-                        else if(JSONObjectIter.value().isDouble())
-                            this->Request->addUserDefinedData(JSONObjectIter.key(), QString("%1").arg(JSONObjectIter.value().toDouble()));
-                        else
-                            this->Request->addUserDefinedData(JSONObjectIter.key(), JSONObjectIter.value().toString());
-                    }
-                }else{
-                    QList<QByteArray> Params = this->RemainingData.split('&');
-                    static auto decodePercentEncoding = [](QByteArray& _value){
-                        _value = _value.replace("+"," ");
-                        QUrl URL = QUrl::fromPercentEncoding("http://127.0.0.1/?key=" + _value);
-                        _value=URL.query(QUrl::FullyDecoded).toUtf8();
-                        _value=_value.mid(_value.indexOf('=') + 1);
-                        return _value;
-                    };
-
-                    foreach(auto Param, Params){
-                        QList<QByteArray> ParamParts = Param.split('=');
-                        if(ParamParts.size() != 2)
-                            throw exHTTPBadRequest("Invalid Param: " + Param);
-                        this->Request->addUserDefinedData(ParamParts.first(), decodePercentEncoding(ParamParts.last()));
-                    }
                 }
+                if(this->RemainingData.size() > ContentLength)
+                    throw exHTTPBadRequest("Request body is larger than content-length");
+                this->parseBufferedBody();
                 break;
             }
             case 'm':{
                 if(this->MultipartFormDataHandler.isNull()){
-                    if(ContentType.startsWith(MULTIPART_BOUNDARY_HEADER) == false)
-                        throw exHTTPBadRequest(("unsupported Content-Type: " + ContentType + " must be " + MULTIPART_BOUNDARY_HEADER).constData());
-
                     this->MultipartFormDataHandler.reset(
                                 new clsMultipartFormDataRequestHandler(
                                     this,
@@ -150,22 +433,18 @@ void clsRequestHandler::process(const QString& _api) {
                                     ));
                 }
 
-                qlonglong Fed = 0;
-                while(!this->MultipartFormDataHandler->stopped() && _data.size() > Fed){
-                    do {
-                        qulonglong Ret = this->MultipartFormDataHandler->feed(_data.mid(static_cast<int>(Fed)).constData(), _data.size() - Fed);
-                        Fed += Ret;
-                    } while (Fed < _data.size() && !this->MultipartFormDataHandler->stopped());
-                }
+                this->MultipartFormDataHandler->feed(_data.constData(), static_cast<size_t>(_data.size()));
                 if(this->MultipartFormDataHandler->hasError())
-                    throw exHTTPBadRequest(this->MultipartFormDataHandler->getErrorMessage());
+                    throw exHTTPBadRequest(this->MultipartFormDataHandler->getErrorMessage().c_str());
                 break;
             }
             default:
                 throw exHTTPBadRequest(("unsupported Content-Type: " + ContentType).constData());
             }
         }catch(exTargomanBase& ex){
-            this->sendError(static_cast<qhttp::TStatusCode>(ex.httpCode()), ex.what(), ex.httpCode() >= 500);
+            if(this->BodyStream)
+                this->BodyStream->abort(ex.what());
+            this->sendError(static_cast<qhttp::TStatusCode>(ex.httpCode()), ex.what(), ex.httpCode() >= 500 || this->ContentLength < 0 || this->BodyStream.isNull() == false);
         }catch(QFieldValidator::exRequiredParam &ex){
             this->sendError(qhttp::ESTATUS_BAD_REQUEST, ex.what(), false);
         }catch(QFieldValidator::exInvalidValue &ex){
@@ -175,21 +454,155 @@ void clsRequestHandler::process(const QString& _api) {
         }
     });
     this->Request->onEnd([this, _api](){
-        try{
-            if(this->Request->method() == qhttp::EHTTP_OPTIONS)
-                this->sendCORSOptions();
-            else
-                this->findAndCallAPI (_api);
-        }catch(exTargomanBase& ex){
-            this->sendError(static_cast<qhttp::TStatusCode>(ex.httpCode()), ex.what(), ex.httpCode() >= 500);
-        }catch(QFieldValidator::exRequiredParam &ex){
-            this->sendError(qhttp::ESTATUS_BAD_REQUEST, ex.what(), false);
-        }catch(QFieldValidator::exInvalidValue &ex){
-            this->sendError(qhttp::ESTATUS_BAD_REQUEST, ex.what(), false);
-        }catch(std::exception &ex){
-            this->sendError(qhttp::ESTATUS_INTERNAL_SERVER_ERROR, ex.what(), true);
-        }
+        this->BodyEnded = true;
+        if(this->BodyStream)
+            this->BodyStream->finish();
+        if(this->APIInvoked == false && this->ResponseSent == false)
+            this->callAPI(_api);
     });
+
+    if(InvokeBeforeBody)
+        this->callAPI(_api);
+}
+
+void clsRequestHandler::parseBufferedBody()
+{
+    int BodyStart = 0, BodyEnd = this->RemainingData.size();
+    while(BodyStart < BodyEnd && isspace(static_cast<unsigned char>(this->RemainingData.at(BodyStart))))
+        ++BodyStart;
+    while(BodyEnd > BodyStart && isspace(static_cast<unsigned char>(this->RemainingData.at(BodyEnd - 1))))
+        --BodyEnd;
+    QByteArray Body = QByteArray::fromRawData(this->RemainingData.constData() + BodyStart, BodyEnd - BodyStart);
+
+    if(Body.startsWith('{') || Body.startsWith('[')){
+        if(Body.startsWith('{') == false || Body.endsWith('}') == false)
+            throw exHTTPBadRequest("Invalid JSON Object");
+        QString Error;
+        QJsonDocument JSON = clsJSONEngine::parse(Body, &Error);
+        if(JSON.isNull() || JSON.isObject() == false)
+            throw exHTTPBadRequest(QString("Invalid JSON Object: %1").arg(Error));
+        this->JSONBody = JSON.object();
+    }else{
+        const char* Data = Body.constData();
+        for(int Start = 0; Start <= Body.size(); ){
+            const char* End = static_cast<const char*>(memchr(Data + Start, '&', static_cast<size_t>(Body.size() - Start)));
+            int Length = (End ? static_cast<int>(End - Data) : Body.size()) - Start;
+            const char* Equal = static_cast<const char*>(memchr(Data + Start, '=', static_cast<size_t>(Length)));
+            if(Equal == nullptr || memchr(Equal + 1, '=', static_cast<size_t>(Data + Start + Length - Equal - 1)))
+                throw exHTTPBadRequest("Invalid Param: " + QByteArray(Data + Start, Length));
+            Start += Length + 1;
+        }
+        /* Form args are indexed the same as query args and decoded just when they are bound */
+        this->BodyArgs = clsQueryArgs(QByteArray(Data, Body.size()));
+    }
+    this->RemainingData.clear();
+}
+
+void clsRequestHandler::callAPI(const QString& _api)
+{
+    if(this->ResponseSent)
+        return;
+    this->APIInvoked = true;
+    try{
+        if(this->Request->method() == qhttp::EHTTP_OPTIONS)
+            return this->sendCORSOptions();
+        if(this->ContentLength < 0 && this->RemainingData.size())
+            this->parseBufferedBody();
+        this->findAndCallAPI (_api);
+    }catch(exTargomanBase& ex){
+        this->sendError(static_cast<qhttp::TStatusCode>(ex.httpCode()), ex.what(), ex.httpCode() >= 500);
+    }catch(QFieldValidator::exRequiredParam &ex){
+        this->sendError(qhttp::ESTATUS_BAD_REQUEST, ex.what(), false);
+    }catch(QFieldValidator::exInvalidValue &ex){
+        this->sendError(qhttp::ESTATUS_BAD_REQUEST, ex.what(), false);
+    }catch(std::exception &ex){
+        this->sendError(qhttp::ESTATUS_INTERNAL_SERVER_ERROR, ex.what(), true);
+    }
+}
+
+/**
+ * qhttp has no flow control and reads everything on readyRead, so read notifications of the socket are filtered while
+ * paused, making the kernel apply TCP backpressure to the client until the API consumes buffered body. Other signals of
+ * the socket are kept so errors and disconnection are still reported to qhttp.
+ */
+void clsRequestHandler::pauseReading()
+{
+    if(this->ReadingPaused || this->Request.isNull())
+        return;
+    QTcpSocket* Socket = this->Request->connection()->tcpSocket();
+    if(this->ReadNotifier.isNull())
+        foreach(QSocketNotifier* Notifier, Socket->findChildren<QSocketNotifier*>())
+            if(Notifier->type() == QSocketNotifier::Read){
+                this->ReadNotifier = Notifier;
+                break;
+            }
+    if(this->ReadNotifier.isNull())
+        return;
+    this->ReadNotifier->installEventFilter(this);
+    this->ReadingPaused = true;
+
+    if(this->PauseProbe == nullptr){
+        this->PauseProbe = new QTimer(this);
+        this->PauseProbe->setInterval(PAUSE_PROBE_INTERVAL_MSECS);
+        QObject::connect(this->PauseProbe, &QTimer::timeout, this, [this](){
+            this->probePausedReading();
+        });
+    }
+    this->PausedTimer.start();
+    this->PauseProbe->start();
+}
+
+void clsRequestHandler::resumeReading()
+{
+    if(this->ReadingPaused == false)
+        return;
+    this->ReadingPaused = false;
+    if(this->PauseProbe)
+        this->PauseProbe->stop();
+    if(this->ReadNotifier.isNull())
+        return;
+    this->ReadNotifier->removeEventFilter(this);
+    this->ReadNotifier->setEnabled(true);
+}
+
+/**
+ * The read notifier is disabled while body data is pending so it does not fire continuously. It is re-enabled
+ * periodically so the event filter can detect a closed connection, and the body stream is aborted when the API has not
+ * consumed it for BodyStreamPauseTimeoutMSecs.
+ */
+void clsRequestHandler::probePausedReading()
+{
+    if(this->ReadingPaused == false || this->ReadNotifier.isNull())
+        return;
+
+    if(gConfigs.Public.BodyStreamPauseTimeoutMSecs &&
+       this->PausedTimer.elapsed() > static_cast<qint64>(gConfigs.Public.BodyStreamPauseTimeoutMSecs)){
+        if(this->BodyStream)
+            this->BodyStream->abort("Request body was not consumed in time");
+        this->resumeReading();
+        if(this->Request)
+            this->Request->connection()->tcpSocket()->abort();
+        return;
+    }
+
+    this->ReadNotifier->setEnabled(true);
+}
+
+/**
+ * Read notifications are swallowed while body data is pending on the socket and the notifier is disabled until next probe.
+ * When nothing but end of stream or an error is pending they are passed through so the socket detects disconnection.
+ */
+bool clsRequestHandler::eventFilter(QObject* _watched, QEvent* _event)
+{
+    if(this->ReadingPaused == false || _event->type() != QEvent::SockAct || _watched != this->ReadNotifier)
+        return false;
+
+    char Byte;
+    ssize_t Peeked = ::recv(static_cast<int>(this->ReadNotifier->socket()), &Byte, 1, MSG_PEEK | MSG_DONTWAIT);
+    if(Peeked <= 0)
+        return false;
+    this->ReadNotifier->setEnabled(false);
+    return true;
 }
 
 const qhttp::TStatusCode StatusCodeOnMethod[] = {
@@ -237,34 +650,27 @@ const qhttp::TStatusCode StatusCodeOnMethod[] = {
 
 void clsRequestHandler::findAndCallAPI(const QString& _api)
 {
+    /* Handler may be already scheduled for deletion so API must not be dispatched */
+    if(this->ResponseSent)
+        return;
+
     if(_api == "/openAPI.json"){
-        gServerStats.Success.inc();
+        incServerStat(gServerStats.Success);
         return this->sendResponseBase(qhttp::ESTATUS_OK, RESTAPIRegistry::retriveOpenAPIJson());
     }
 
     if(_api == "/openAPI.yaml")
         throw exHTTPMethodNotAllowed("Yaml openAPI is not implemented yet");
 
-    QString ExtraAPIPath;
-
-    clsAPIObject* APIObject = RESTAPIRegistry::getAPIObject(this->Request->methodString(), _api);
-    if(!APIObject) {
-        QString Path = _api;
-        if(Path.endsWith('/'))
-            Path.truncate(Path.size() - 1);
-        ExtraAPIPath = Path.mid(Path.lastIndexOf('/') + 1);
-        Path = Path.mid(0, Path.lastIndexOf('/'));
-        APIObject = RESTAPIRegistry::getAPIObject(this->Request->methodString(), Path);
-    }
+    clsAPIObject* APIObject = this->APIObject;
+    QString ExtraAPIPath = this->ExtraAPIPath;
 
     if(!APIObject)
         return this->sendError(qhttp::ESTATUS_NOT_FOUND,
                                "API not found("+this->Request->methodString()+": "+_api+")",
                                true);
 
-    QStringList Queries = this->Request->url().query().split('&', QString::SkipEmptyParts);
-    for(auto QueryIter = Queries.begin(); QueryIter != Queries.end(); ++QueryIter)
-        *QueryIter = QueryIter->replace('+', ' ');
+    clsQueryArgs Queries(this->Request->url().query(QUrl::FullyEncoded).toLatin1());
 
     qhttp::THeaderHash Headers = this->Request->headers();
     qhttp::THeaderHash Cookies;
@@ -289,22 +695,146 @@ void clsRequestHandler::findAndCallAPI(const QString& _api)
     Headers.remove("cookie");
 
 
-    this->sendResponse(
-                StatusCodeOnMethod[this->Request->method()],
-            APIObject->invoke(Queries,
-                              this->Request->userDefinedValues(),
-                              Headers,
-                              Cookies,
-                              JWT,
-                              this->toIPv4(this->Request->remoteAddress()),
-                              ExtraAPIPath
-                              )
-            );
+    qhttp::TStatusCode StatusCode = StatusCodeOnMethod[this->Request->method()];
+    /* Spool files are referred by their fd so invocations share their ownership and fds can not be reused meanwhile */
+    QList<QSharedPointer<clsUploadSpool>> Spools;
+    if(this->MultipartFormDataHandler.isNull() == false)
+        Spools = this->MultipartFormDataHandler->spools();
+
+    QHttp::AsyncResponse_t AsyncResponse;
+    if(APIObject->isAsync()){
+        AsyncResponse = QHttp::AsyncResponse_t(this, StatusCode);
+        AsyncResponse.State->Spools = Spools;
+        this->ResultPending = true;
+    }
+
+    auto APIInvoker = [APIObject,
+                       Queries,
+                       BodyArgs = this->BodyArgs,
+                       Headers,
+                       Cookies,
+                       JWT,
+                       RemoteIP = this->toIPv4(this->Request->remoteAddress()),
+                       ExtraAPIPath,
+                       PathArgs = this->PathArgs,
+                       JSONBody = this->JSONBody,
+                       BodyStream = QHttp::BodyStream_t(this->BodyStream),
+                       Spools,
+                       AsyncResponse](){
+        clsUploadSpool::stuClaimScope ClaimScope(Spools);
+        return APIObject->invoke(Queries,
+                                 BodyArgs,
+                                 Headers,
+                                 Cookies,
+                                 JWT,
+                                 RemoteIP,
+                                 ExtraAPIPath,
+                                 AsyncResponse,
+                                 PathArgs,
+                                 JSONBody,
+                                 BodyStream
+                                 );
+    };
+
+    if(APIObject->isAsync()){
+        /// Async APIs will respond through AsyncResponse so errors are also delivered through it to avoid double responses
+        auto AsyncAPIInvoker = [APIInvoker, AsyncResponse](){
+            try{
+                APIInvoker();
+            }catch(exTargomanBase& ex){
+                AsyncResponse.reject(ex);
+            }catch(QFieldValidator::exRequiredParam &ex){
+                AsyncResponse.reject(qhttp::ESTATUS_BAD_REQUEST, ex.what());
+            }catch(QFieldValidator::exInvalidValue &ex){
+                AsyncResponse.reject(qhttp::ESTATUS_BAD_REQUEST, ex.what());
+            }catch(std::exception &ex){
+                AsyncResponse.reject(qhttp::ESTATUS_INTERNAL_SERVER_ERROR, ex.what());
+            }
+        };
+        if(clsRequestHandler::APIExecutor.isNull())
+            return AsyncAPIInvoker();
+        clsRequestHandler::APIExecutor->start(APIObject->moduleName(), new clsAPIInvocation(AsyncAPIInvoker, [AsyncResponse](){
+            AsyncResponse.State->post(clsAPIInvocation::makeShedEvent());
+        }));
+        return;
+    }
+
+    if(clsRequestHandler::APIExecutor.isNull())
+        return this->sendResponse(StatusCode, APIInvoker());
+
+    this->ResultPending = true;
+    clsRequestHandler::APIExecutor->start(APIObject->moduleName(), new clsAPIInvocation(this, StatusCode, APIInvoker));
+}
+
+void clsRequestHandler::customEvent(QEvent* _event)
+{
+#ifdef QHTTP_ENABLE_COROUTINES
+    if(_event->type() == clsTaskResumeEvent::type())
+        return static_cast<clsTaskResumeEvent*>(_event)->Handle.resume();
+#endif
+
+    if(_event->type() != clsAPIResultEvent::type())
+        return;
+
+    clsAPIResultEvent* ResultEvent = static_cast<clsAPIResultEvent*>(_event);
+    this->ResultPending = false;
+    if(ResultEvent->Shed)
+        this->sendShedResponse();
+    else if(ResultEvent->IsError)
+        this->sendError(ResultEvent->StatusCode, ResultEvent->ErrorMessage, ResultEvent->CloseConnection);
+    else
+        this->sendResponse(ResultEvent->StatusCode, ResultEvent->Result);
+}
+
+#ifdef QHTTP_ENABLE_COROUTINES
+void clsRequestHandler::startTask(QHttp::Task&& _task, const QHttp::AsyncResponse_t& _asyncResponse)
+{
+    if(_asyncResponse.State.isNull())
+        throw exHTTPInternalServerError("Coroutine APIs can only be invoked by HTTP requests");
+
+    clsRequestHandler* RequestHandler = static_cast<clsRequestHandler*>(_asyncResponse.State->RequestHandler);
+    _task.start(RequestHandler, [_asyncResponse](QHttp::Task::promise_type& _promise){
+        if(!_promise.Exception)
+            return _asyncResponse.resolve(_promise.Result);
+
+        try{
+            std::rethrow_exception(_promise.Exception);
+        }catch(exTargomanBase& ex){
+            _asyncResponse.reject(ex);
+        }catch(QFieldValidator::exRequiredParam &ex){
+            _asyncResponse.reject(qhttp::ESTATUS_BAD_REQUEST, ex.what());
+        }catch(QFieldValidator::exInvalidValue &ex){
+            _asyncResponse.reject(qhttp::ESTATUS_BAD_REQUEST, ex.what());
+        }catch(std::exception &ex){
+            _asyncResponse.reject(qhttp::ESTATUS_INTERNAL_SERVER_ERROR, ex.what());
+        }
+    });
+}
+
+void clsRequestHandler::resume(std::coroutine_handle<> _handle)
+{
+    QCoreApplication::postEvent(this, new clsTaskResumeEvent(_handle));
+}
+
+void clsRequestHandler::resumeAfter(std::coroutine_handle<> _handle, int _msecs)
+{
+    QTimer::singleShot(_msecs, this, [_handle](){ _handle.resume(); });
 }
 
+bool clsRequestHandler::isCancelled()
+{
+    return this->Response.isNull() || this->Request.isNull();
+}
+
+void startAPITask(QHttp::Task&& _task, const QHttp::AsyncResponse_t& _asyncResponse)
+{
+    clsRequestHandler::startTask(std::move(_task), _asyncResponse);
+}
+#endif
+
 void clsRequestHandler::sendError(qhttp::TStatusCode _code, const QString& _message, bool _closeConnection)
 {
-    gServerStats.Errors.inc();
+    incServerStat(gServerStats.Errors);
     this->sendResponseBase(_code,
                            QJsonObject({
                                            {"error",
@@ -320,12 +850,16 @@ void clsRequestHandler::sendError(qhttp::TStatusCode _code, const QString& _mess
 
 void clsRequestHandler::sendResponse(qhttp::TStatusCode _code, QVariant _response)
 {
-    gServerStats.Success.inc();
+    incServerStat(gServerStats.Success);
     this->sendResponseBase(_code, QJsonObject({{"result", QJsonValue::fromVariant(_response) }}));
 }
 
 void clsRequestHandler::sendCORSOptions()
 {
+    if(this->Response.isNull()){
+        this->finish();
+        return;
+    }
     this->Response->addHeaderValue("Access-Control-Allow-Origin", gConfigs.Public.AccessControl);
     this->Response->addHeaderValue("Access-Control-Allow-Credentials", QString("true"));
     this->Response->addHeaderValue("Access-Control-Allow-Methods", QString("GET, POST, PUT, PATCH, DELETE"));
@@ -335,10 +869,67 @@ void clsRequestHandler::sendCORSOptions()
     this->Response->addHeaderValue("content-type", QString("application/json; charset=utf-8"));
     this->Response->setStatusCode(qhttp::ESTATUS_NO_CONTENT);
     this->Response->end();
-    this->deleteLater();
+    this->finish();
+}
+
+void clsRequestHandler::sendShedResponse()
+{
+    static const QByteArray ShedResponse = QJsonDocument(QJsonObject({
+                                                                          {"error",
+                                                                           QJsonObject({
+                                                                               {"code", qhttp::ESTATUS_SERVICE_UNAVAILABLE},
+                                                                               {"message", "Server is overloaded, try again later"}
+                                                                           })
+                                                                          }
+                                                                      })).toJson(QJsonDocument::Compact);
+    incServerStat(gServerStats.Shed);
+    this->sendRejectResponse(qhttp::ESTATUS_SERVICE_UNAVAILABLE, ShedResponse);
+}
+
+void clsRequestHandler::sendRateLimitedResponse()
+{
+    static const QByteArray RateLimitedResponse = QJsonDocument(QJsonObject({
+                                                                                 {"error",
+                                                                                  QJsonObject({
+                                                                                      {"code", qhttp::ESTATUS_TOO_MANY_REQUESTS},
+                                                                                      {"message", "Rate limit exceeded, try again later"}
+                                                                                  })
+                                                                                 }
+                                                                             })).toJson(QJsonDocument::Compact);
+    TargomanLogWarn(5, "Request from " + this->Request->remoteAddress() + " was rejected by rate limiter");
+    incServerStat(gServerStats.Blocked);
+    this->sendRejectResponse(qhttp::ESTATUS_TOO_MANY_REQUESTS, RateLimitedResponse);
+}
+
+void clsRequestHandler::sendRejectResponse(qhttp::TStatusCode _code, const QByteArray& _body)
+{
+    if(this->Response.isNull()){
+        this->finish();
+        return;
+    }
+
+    this->Response->setStatusCode(_code);
+    this->Response->addHeader("connection", "close");
+    this->Response->addHeaderValue("retry-after", gConfigs.Public.RetryAfterSecs);
+    this->Response->addHeaderValue("content-length", _body.length());
+    this->Response->addHeaderValue("content-type", QString("application/json; charset=utf-8"));
+    this->Response->addHeaderValue("Access-Control-Allow-Origin", QString("*"));
+    this->Response->end(_body);
+    this->finish();
 }
 
 void clsRequestHandler::sendResponseBase(qhttp::TStatusCode _code, QJsonObject _dataObject, bool _closeConnection){
+    /* Streaming APIs may respond while an error is being reported on the body or vice versa */
+    if(this->ResponseSent)
+        return this->finish();
+    this->ResponseSent = true;
+    this->detachBody();
+
+    if(this->Response.isNull() || this->Request.isNull()){
+        TargomanLogWarn(1, "Connection closed before response was sent");
+        this->finish();
+        return;
+    }
 
     QByteArray Data = QJsonDocument(_dataObject).toJson(gConfigs.Public.IndentedJson ? QJsonDocument::Indented : QJsonDocument::Compact);
 
@@ -348,145 +939,159 @@ void clsRequestHandler::sendResponseBase(qhttp::TStatusCode _code, QJsonObject _
                     this->Request->connection()->tcpSocket()->peerPort()<<
                     "]: (code:"<<_code<<"):"<<Data)
     this->Response->setStatusCode(_code);
-    if(_closeConnection) this->Response->addHeader("connection", "close");
+    /* Unread body of a streaming API can not be skipped safely so connection is closed */
+    if(_closeConnection || gConfigs.Private.IsDraining.load() || (this->BodyStream && this->BodyEnded == false))
+        this->Response->addHeader("connection", "close");
     this->Response->addHeaderValue("content-length", Data.length());
     this->Response->addHeaderValue("content-type", QString("application/json; charset=utf-8"));
     this->Response->addHeaderValue("Access-Control-Allow-Origin", QString("*"));
     this->Response->end(Data.constData());
-    this->deleteLater();
+    this->finish();
 }
 
 /**************************************************************************/
-void clsMultipartFormDataRequestHandler::onMultiPartBegin(const MultipartHeaders& _headers, void *_userData) {
-    clsMultipartFormDataRequestHandler *Self = static_cast<clsMultipartFormDataRequestHandler*>(_userData);
-    try{
-        std::string ContentDisposition = _headers["Content-Disposition"];
-        if(ContentDisposition.size()){
-            const char* pContentDisposition = ContentDisposition.c_str();
-            const char* pBufferStart = pContentDisposition;
-            enum enuLooking4{
-                L4Type,
-                L4Field,
-                L4NextField,
-                L4DQuote,
-                L4Value,
-            } Looking4 = L4Type;
-            char StopChar = ';';
-            std::string* pLastFieldValue = nullptr;
-            std::string Dummy;
-
-            while(pContentDisposition && *pContentDisposition != '\0'){
-                if(*pContentDisposition == StopChar)
-                    switch(Looking4){
-                    case L4Type:
-                        if(strncmp(pBufferStart, "form-data", static_cast<size_t>(pContentDisposition - pBufferStart)))
-                            throw exHTTPBadRequest("Just form-data is allowed in multi-part request according to RFC7578");
-                        Looking4 = L4Field;
-                        pBufferStart = pContentDisposition+1;
-                        StopChar = '=';
-                        break;
-                    case L4Field:
-                        if(strncmp(pBufferStart, " name", static_cast<size_t>(pContentDisposition - pBufferStart)) == 0)
-                            pLastFieldValue = &Self->LastItemName;
-                        else if(strncmp(pBufferStart, " filename", static_cast<size_t>(pContentDisposition - pBufferStart)) == 0)
-                            pLastFieldValue = &Self->LastFileName;
-                        else
-                            pLastFieldValue = &Dummy;
-                        Looking4 = L4DQuote;
-                        StopChar = '"';
-                        break;
-                    case L4NextField:
-                        Looking4 = L4Field;
-                        pBufferStart = pContentDisposition+1;
-                        StopChar = '=';
-                        break;
-                    case L4DQuote:
-                        Looking4 = L4Value;
-                        StopChar = '"';
-                        pBufferStart = pContentDisposition+1;
-                        break;
-                    case L4Value:
-                        *pLastFieldValue = pBufferStart;
-                        pLastFieldValue->erase(static_cast<size_t>(pContentDisposition - pBufferStart), std::string::npos);
-                        StopChar=';';
-                        Looking4 = L4NextField;
-                        pBufferStart = pContentDisposition+2;
-                        break;
-                    }
-                else if(*pContentDisposition == '\r')
+void clsMultipartFormDataRequestHandler::onPartBegin(const stuMultipartHeaders& _headers) {
+    /* Errors are propagated through feed"()" to the request handler which stops parsing the rest of the body */
+    std::string ContentDisposition = _headers.value("Content-Disposition");
+    if(ContentDisposition.size()){
+        const char* pContentDisposition = ContentDisposition.c_str();
+        const char* pBufferStart = pContentDisposition;
+        enum enuLooking4{
+            L4Type,
+            L4Field,
+            L4NextField,
+            L4DQuote,
+            L4Value,
+        } Looking4 = L4Type;
+        char StopChar = ';';
+        std::string* pLastFieldValue = nullptr;
+        std::string Dummy;
+
+        while(pContentDisposition && *pContentDisposition != '\0'){
+            if(*pContentDisposition == StopChar)
+                switch(Looking4){
+                case L4Type:
+                    if(strncmp(pBufferStart, "form-data", static_cast<size_t>(pContentDisposition - pBufferStart)))
+                        throw exHTTPBadRequest("Just form-data is allowed in multi-part request according to RFC7578");
+                    Looking4 = L4Field;
+                    pBufferStart = pContentDisposition+1;
+                    StopChar = '=';
                     break;
-                ++pContentDisposition;
-            }
+                case L4Field:
+                    if(strncmp(pBufferStart, " name", static_cast<size_t>(pContentDisposition - pBufferStart)) == 0)
+                        pLastFieldValue = &this->LastItemName;
+                    else if(strncmp(pBufferStart, " filename", static_cast<size_t>(pContentDisposition - pBufferStart)) == 0)
+                        pLastFieldValue = &this->LastFileName;
+                    else
+                        pLastFieldValue = &Dummy;
+                    Looking4 = L4DQuote;
+                    StopChar = '"';
+                    break;
+                case L4NextField:
+                    Looking4 = L4Field;
+                    pBufferStart = pContentDisposition+1;
+                    StopChar = '=';
+                    break;
+                case L4DQuote:
+                    Looking4 = L4Value;
+                    StopChar = '"';
+                    pBufferStart = pContentDisposition+1;
+                    break;
+                case L4Value:
+                    *pLastFieldValue = pBufferStart;
+                    pLastFieldValue->erase(static_cast<size_t>(pContentDisposition - pBufferStart), std::string::npos);
+                    StopChar=';';
+                    Looking4 = L4NextField;
+                    pBufferStart = pContentDisposition+2;
+                    break;
+                }
+            else if(*pContentDisposition == '\r')
+                break;
+            ++pContentDisposition;
+        }
 
-            if(Self->LastItemName.empty())
-                throw exHTTPBadRequest(QString("No name provided for form field: ") + ContentDisposition.c_str());
-            if(Self->ToBeStoredItemName.empty())
-                Self->ToBeStoredItemName = Self->LastItemName;
-
-            if(Self->LastFileName.size()){
-                Self->LastTempFile.reset(new QTemporaryFile);
-                if(Self->LastTempFile.isNull() || Self->LastTempFile->open() == false)
-                    throw exHTTPInternalServerError("unable to create temporary file");
-                Self->LastTempFile->setAutoRemove(false);
-                Self->LastMime = _headers["Content-Type"];
-            }
-        }else
-            throw exHTTPBadRequest("No Content-Disposition header provided");
-    }catch(exHTTPError& ex){
-        Self->pRequestHandler->sendError(static_cast<qhttp::TStatusCode>(ex.code()), ex.what(), ex.code() >= 500);
-    }catch(exTargomanBase& ex){
-        Self->pRequestHandler->sendError(qhttp::ESTATUS_INTERNAL_SERVER_ERROR, ex.what(), true);
-    }
+        if(this->LastItemName.empty())
+            throw exHTTPBadRequest(QString("No name provided for form field: ") + ContentDisposition.c_str());
+        if(this->ToBeStoredItemName.empty())
+            this->ToBeStoredItemName = this->LastItemName;
 
+        if(this->LastFileName.size()){
+            QList<QCryptographicHash::Algorithm> Digests = gConfigs.Public.UploadDigests;
+            if(gConfigs.Public.UploadStoreDirectory.size() && Digests.contains(QCryptographicHash::Sha256) == false)
+                Digests.append(QCryptographicHash::Sha256);
+            this->LastSpool.reset(new clsUploadSpool(gConfigs.Public.UploadMemoryThreshold, Digests));
+            this->LastMime = _headers.value("Content-Type");
+        }
+    }else
+        throw exHTTPBadRequest("No Content-Disposition header provided");
 }
 
-void clsMultipartFormDataRequestHandler::onMultiPartData(const char *_buffer, long long _size, void *_userData) {
-    clsMultipartFormDataRequestHandler *Self = static_cast<clsMultipartFormDataRequestHandler*>(_userData);
-    if(Self->LastTempFile.isNull() == false){
-        Self->LastWrittenBytes += Self->LastTempFile->write(_buffer, _size);
-        if(Self->LastWrittenBytes > gConfigs.Public.MaxUploadedFileSize)
+void clsMultipartFormDataRequestHandler::onPartData(const char *_buffer, size_t _size) {
+    if(this->LastSpool.isNull() == false){
+        if(this->LastSpool->size() + static_cast<qint64>(_size) > gConfigs.Public.MaxUploadedFileSize)
             throw exHTTPPayloadTooLarge("Max file size limit reached");
+        this->UploadedBytes += static_cast<qint64>(_size);
+        if(gConfigs.Public.MaxUploadedBytesPerRequest && this->UploadedBytes > gConfigs.Public.MaxUploadedBytesPerRequest)
+            throw exHTTPPayloadTooLarge("Max uploaded files size per request limit reached");
+        this->LastSpool->write(_buffer, _size);
     }else
-        Self->LastValue = QString::fromUtf8(_buffer, static_cast<int>(_size));
+        this->LastValue.append(_buffer, static_cast<int>(_size));
 }
 
-void clsMultipartFormDataRequestHandler::onMultiPartEnd(void *_userData) {
-    clsMultipartFormDataRequestHandler *Self = static_cast<clsMultipartFormDataRequestHandler*>(_userData);
-    if(Self->ToBeStoredItemName != Self->LastItemName){
-        Self->storeDataInRequest();
-        Self->SameNameItems.clear();
-        Self->ToBeStoredItemName = Self->LastItemName;
+void clsMultipartFormDataRequestHandler::onPartEnd() {
+    if(this->ToBeStoredItemName != this->LastItemName){
+        this->storeDataInRequest();
+        this->SameNameItems.clear();
+        this->ToBeStoredItemName = this->LastItemName;
     }
-    if(Self->LastTempFile.isNull() == false){
-        Self->SameNameItems.append(
-                    QString("{\"name\":\"%1\",\"tmpname\":\"%2\",\"size\":\"%3\",\"type\":\"%4\"}").arg(
-                        Self->LastFileName.c_str()).arg(
-                        Self->LastTempFile->fileName()).arg(
-                        Self->LastWrittenBytes).arg(
-                        Self->LastMime.c_str()));
-        Self->LastTempFile.reset();
+    if(this->LastSpool.isNull() == false){
+        this->LastSpool->finish();
+        if(gConfigs.Public.UploadStoreDirectory.size())
+            this->LastSpool->store(gConfigs.Public.UploadStoreDirectory);
+
+        QJsonObject FileInfo({
+                                 {"id",   this->LastSpool->id()},
+                                 {"name", QString::fromStdString(this->LastFileName)},
+                                 {"size", QString::number(this->LastSpool->size())},
+                                 {"type", QString::fromStdString(this->LastMime)},
+                             });
+        QVariantMap Digests = this->LastSpool->digests();
+        if(Digests.size())
+            FileInfo.insert("digest", QJsonObject::fromVariantMap(Digests));
+
+        if(this->LastSpool->storedPath().size()){
+            FileInfo.insert("tmpname", this->LastSpool->storedPath());
+            FileInfo.insert("stored", true);
+            if(this->LastSpool->duplicate())
+                FileInfo.insert("duplicate", true);
+        }else if(this->LastSpool->inMemory())
+            FileInfo.insert("data", QString::fromLatin1(this->LastSpool->data().toBase64()));
+        else
+            FileInfo.insert("tmpname", this->LastSpool->path());
+        this->SameNameItems.append(QString::fromUtf8(QJsonDocument(FileInfo).toJson(QJsonDocument::Compact)));
+        /* Spooled files are kept open until the request handler and API invocations using them are gone */
+        this->Spools.append(QSharedPointer<clsUploadSpool>(this->LastSpool.take()));
     }else
-        Self->SameNameItems.append(Self->LastValue);
+        this->SameNameItems.append(QString::fromUtf8(this->LastValue));
+    this->LastValue.clear();
 
 
-    Self->LastFileName.clear();
-    Self->LastItemName.clear();
-    Self->LastMime.clear();
-    Self->LastWrittenBytes = 0;
+    this->LastFileName.clear();
+    this->LastItemName.clear();
+    this->LastMime.clear();
 }
 
-void clsMultipartFormDataRequestHandler::onDataEnd(void *_userData){
-    clsMultipartFormDataRequestHandler *Self = static_cast<clsMultipartFormDataRequestHandler*>(_userData);
-    if(Self->SameNameItems.size())
-        Self->storeDataInRequest();
+void clsMultipartFormDataRequestHandler::onEnd(){
+    if(this->SameNameItems.size())
+        this->storeDataInRequest();
 }
 
 void clsMultipartFormDataRequestHandler::storeDataInRequest()
 {
     if(this->SameNameItems.size() > 1)
-        this->pRequestHandler->Request->addUserDefinedData(this->ToBeStoredItemName.c_str(), QString("[%1]").arg(this->SameNameItems.join(',')));
+        this->pRequestHandler->BodyArgs.append(this->ToBeStoredItemName.c_str(), QString("[%1]").arg(this->SameNameItems.join(',')));
     else
-        this->pRequestHandler->Request->addUserDefinedData(this->ToBeStoredItemName.c_str(), this->SameNameItems.at(0));
+        this->pRequestHandler->BodyArgs.append(this->ToBeStoredItemName.c_str(), this->SameNameItems.at(0));
 }
 
 QString  clsRequestHandler::toIPv4(const QString _ip)
@@ -497,4 +1102,49 @@ QString  clsRequestHandler::toIPv4(const QString _ip)
 }
 
 }
+
+/***********************************************************************************************/
+#ifdef QHTTP_ENABLE_COROUTINES
+clsThreadPoolAwaiter centralCacheValue(const QString& _key)
+{
+    return clsThreadPoolAwaiter([_key](){ return Private::CentralCache::storedValue(_key); });
+}
+#endif
+
+AsyncResponse_t::AsyncResponse_t(QObject* _requestHandler, qhttp::TStatusCode _code) :
+    State(new Private::stuAsyncResponseState(_requestHandler, _code))
+{}
+
+void AsyncResponse_t::resolve(const QVariant& _result) const
+{
+    if(this->State)
+        this->State->post(new Private::clsAPIResultEvent(this->State->StatusCode, _result));
+}
+
+void AsyncResponse_t::reject(const Targoman::Common::exTargomanBase& _exception) const
+{
+    this->reject(static_cast<quint16>(_exception.httpCode()), _exception.what());
+}
+
+void AsyncResponse_t::reject(quint16 _httpCode, const QString& _message) const
+{
+    if(this->State)
+        this->State->post(new Private::clsAPIResultEvent(static_cast<qhttp::TStatusCode>(_httpCode), _message, _httpCode >= 500));
+}
+
+QIODevice* BodyStream_t::device() const
+{
+    return this->Stream.data();
+}
+
+bool BodyStream_t::isAborted() const
+{
+    return this->Stream && this->Stream->isAborted();
+}
+
+QString BodyStream_t::errorString() const
+{
+    return this->Stream ? this->Stream->abortReason() : QString();
+}
+
 }
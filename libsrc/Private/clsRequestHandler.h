@@ -24,11 +24,20 @@
 #ifndef QHTTP_PRIVATE_CLSREQUESTHANDLER_H
 #define QHTTP_PRIVATE_CLSREQUESTHANDLER_H
 
-#include <QTemporaryFile>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QEvent>
+#include <QSocketNotifier>
+#include <QElapsedTimer>
 #include "QHttp/QHttpServer"
+#include "QHttp/Task.hpp"
 #include "RESTAPIRegistry.h"
 #include "Private/Configs.hpp"
-#include "3rdParty/multipart-parser/MultipartReader.h"
+#include "Private/clsAPIExecutor.h"
+#include "Private/clsMultipartParser.h"
+#include "Private/clsUploadSpool.h"
+#include "Private/clsBodyStream.h"
+#include "Private/clsQueryArgs.h"
 
 namespace QHttp {
 namespace Private {
@@ -41,32 +50,32 @@ private:
     void run() Q_DECL_FINAL {
         QTimer Timer;
         QObject::connect(&Timer, &QTimer::timeout, [](){
-            gServerStats.Connections.snapshot(gConfigs.Public.StatisticsInterval);
-            gServerStats.WSConnections.snapshot(gConfigs.Public.StatisticsInterval);
-            gServerStats.Errors.snapshot(gConfigs.Public.StatisticsInterval);
-            gServerStats.Blocked.snapshot(gConfigs.Public.StatisticsInterval);
-            gServerStats.Success.snapshot(gConfigs.Public.StatisticsInterval);
-
-            for (auto ListIter = gServerStats.APICallsStats.begin ();
-                 ListIter != gServerStats.APICallsStats.end ();
-                 ++ListIter)
-                ListIter->snapshot(gConfigs.Public.StatisticsInterval);
-            for (auto ListIter = gServerStats.APIInternalCacheStats.begin ();
-                 ListIter != gServerStats.APIInternalCacheStats.end ();
-                 ++ListIter)
-                ListIter->snapshot(gConfigs.Public.StatisticsInterval);
-
-            QList<Cache_t::const_iterator> ToDeleteIters;
+            {
+                QMutexLocker Locker(&gServerStatsLock);
+                gServerStats.Connections.snapshot(gConfigs.Public.StatisticsInterval);
+                gServerStats.WSConnections.snapshot(gConfigs.Public.StatisticsInterval);
+                gServerStats.Errors.snapshot(gConfigs.Public.StatisticsInterval);
+                gServerStats.Blocked.snapshot(gConfigs.Public.StatisticsInterval);
+                gServerStats.Shed.snapshot(gConfigs.Public.StatisticsInterval);
+                gServerStats.Success.snapshot(gConfigs.Public.StatisticsInterval);
+
+                for (auto ListIter = gServerStats.APICallsStats.begin ();
+                     ListIter != gServerStats.APICallsStats.end ();
+                     ++ListIter)
+                    ListIter->snapshot(gConfigs.Public.StatisticsInterval);
+                for (auto ListIter = gServerStats.APIInternalCacheStats.begin ();
+                     ListIter != gServerStats.APIInternalCacheStats.end ();
+                     ++ListIter)
+                    ListIter->snapshot(gConfigs.Public.StatisticsInterval);
+            }
+
+            QWriteLocker Locker(&InternalCache::Lock);
             for(auto CacheIter = InternalCache::Cache.begin();
-                CacheIter != InternalCache::Cache.end();
-                ++CacheIter)
+                CacheIter != InternalCache::Cache.end();){
                 if(CacheIter->InsertionTime.secsTo(QTime::currentTime()) > CacheIter->TTL)
-                    ToDeleteIters.append(CacheIter);
-
-            if(ToDeleteIters.size()){
-                QMutexLocker Locker(&InternalCache::Lock);
-                foreach(auto Iter, ToDeleteIters)
-                    InternalCache::Cache.erase(Iter);
+                    CacheIter = InternalCache::Cache.erase(CacheIter);
+                else
+                    ++CacheIter;
             }
         });
 
@@ -75,51 +84,121 @@ private:
     }
 };
 
-class clsMultipartFormDataRequestHandler : public MultipartReader{
+class clsMultipartFormDataRequestHandler : public clsMultipartParser{
 public:
     clsMultipartFormDataRequestHandler(clsRequestHandler* _parent, const QByteArray& _marker) :
-        MultipartReader(_marker.toStdString()),
-        pRequestHandler(_parent),
-        LastWrittenBytes(0){
-        this->onPartBegin = clsMultipartFormDataRequestHandler::onMultiPartBegin;
-        this->onPartData = clsMultipartFormDataRequestHandler::onMultiPartData;
-        this->onPartEnd = clsMultipartFormDataRequestHandler::onMultiPartEnd;
-        this->onEnd = clsMultipartFormDataRequestHandler::onDataEnd;
-        this->userData = reinterpret_cast<void*>(this);
-    }
+        clsMultipartParser(_marker.toStdString()),
+        pRequestHandler(_parent)
+    {}
 
-    size_t feed(const char *_buffer, long long  _len){
-        return static_cast<size_t>(MultipartReader::feed(_buffer, _len));
-    }
+    inline const QList<QSharedPointer<clsUploadSpool>>& spools() const { return this->Spools; }
 
 private:
-    static void onMultiPartBegin(const MultipartHeaders& _headers, void *_userData);
-    static void onMultiPartData(const char *_buffer, long long _size, void *_userData);
-    static void onMultiPartEnd(void *_userData);
-    static void onDataEnd(void *_userData);
+    void onPartBegin(const stuMultipartHeaders& _headers) Q_DECL_FINAL;
+    void onPartData(const char *_buffer, size_t _size) Q_DECL_FINAL;
+    void onPartEnd() Q_DECL_FINAL;
+    void onEnd() Q_DECL_FINAL;
 
     void storeDataInRequest();
 
 private:
     clsRequestHandler*              pRequestHandler;
-    QScopedPointer<QTemporaryFile>  LastTempFile;
+    QScopedPointer<clsUploadSpool>  LastSpool;
+    QList<QSharedPointer<clsUploadSpool>> Spools;
     std::string                     LastMime;
     std::string                     LastFileName;
     std::string                     ToBeStoredItemName;
     std::string                     LastItemName;
-    QString                         LastValue;
-    int                             LastWrittenBytes;
+    QByteArray                      LastValue;
     QStringList                     SameNameItems;
+    qint64                          UploadedBytes = 0;
 
     friend class clsRequestHandler;
 };
 
+/**
+ * @brief The clsAPIResultEvent class is used to post result of an API invoked on worker threads back to the
+ *        thread owning the connection
+ */
+class clsAPIResultEvent : public QEvent{
+public:
+    clsAPIResultEvent(qhttp::TStatusCode _code, const QVariant& _result) :
+        QEvent(clsAPIResultEvent::type()),
+        StatusCode(_code),
+        Result(_result),
+        IsError(false),
+        CloseConnection(false)
+    {}
+    clsAPIResultEvent(qhttp::TStatusCode _code, const QString& _message, bool _closeConnection) :
+        QEvent(clsAPIResultEvent::type()),
+        StatusCode(_code),
+        IsError(true),
+        ErrorMessage(_message),
+        CloseConnection(_closeConnection)
+    {}
+
+    static QEvent::Type type(){
+        static int EventType = QEvent::registerEventType();
+        return static_cast<QEvent::Type>(EventType);
+    }
+
+    qhttp::TStatusCode StatusCode;
+    QVariant           Result;
+    bool               IsError;
+    QString            ErrorMessage;
+    bool               CloseConnection;
+    bool               Shed = false;
+};
+
+#ifdef QHTTP_ENABLE_COROUTINES
+/**
+ * @brief The clsTaskResumeEvent class is used to resume coroutine APIs on the thread owning the connection
+ */
+class clsTaskResumeEvent : public QEvent{
+public:
+    clsTaskResumeEvent(std::coroutine_handle<> _handle) :
+        QEvent(clsTaskResumeEvent::type()),
+        Handle(_handle)
+    {}
+
+    static QEvent::Type type(){
+        static int EventType = QEvent::registerEventType();
+        return static_cast<QEvent::Type>(EventType);
+    }
+
+    std::coroutine_handle<> Handle;
+};
+#endif
+
+/**
+ * @brief The stuAsyncResponseState struct is shared between all copies of an AsyncResponse_t and guarantees that just one
+ *        result will be posted to the request handler
+ */
+struct stuAsyncResponseState{
+    stuAsyncResponseState(QObject* _requestHandler, qhttp::TStatusCode _code) :
+        RequestHandler(_requestHandler),
+        StatusCode(_code)
+    {}
+    ~stuAsyncResponseState();
+
+    void post(clsAPIResultEvent* _event);
+
+    QObject*           RequestHandler;
+    qhttp::TStatusCode StatusCode;
+    QAtomicInt         Delivered;
+    QList<QSharedPointer<clsUploadSpool>> Spools; ///< Uploaded files are kept open until the async API responds
+};
+
 class clsRequestHandler :QObject
+#ifdef QHTTP_ENABLE_COROUTINES
+        , public intfTaskContext
+#endif
 {
 public:
     clsRequestHandler(qhttp::server::QHttpRequest* _req,
                       qhttp::server::QHttpResponse* _res,
                       QObject *_parent = nullptr);
+    ~clsRequestHandler();
     void process(const QString& _api);
     void findAndCallAPI(const QString& _api);
     void sendError(qhttp::TStatusCode _code,
@@ -127,15 +206,70 @@ public:
                    bool _closeConnection = false);
     void sendResponse(qhttp::TStatusCode _code, QVariant _response);
     void sendCORSOptions();
+    void sendShedResponse();
+    void sendRateLimitedResponse();
+
+    static void startAPIWorkers(quint16 _count);
+    static void stopAPIWorkers();
+    static QHash<QByteArray, stuQueueStatistics> apiQueueStats();
+    static quint32 inFlightRequests();
+
+#ifdef QHTTP_ENABLE_COROUTINES
+    static void startTask(QHttp::Task&& _task, const QHttp::AsyncResponse_t& _asyncResponse);
+    void resume(std::coroutine_handle<> _handle) Q_DECL_FINAL;
+    void resumeAfter(std::coroutine_handle<> _handle, int _msecs) Q_DECL_FINAL;
+    bool isCancelled() Q_DECL_FINAL;
+#endif
+
 private:
     void sendResponseBase(qhttp::TStatusCode _code, QJsonObject _dataObject, bool _closeConnection = false);
+    void resolveAPI(const QString& _api);
+    bool admit();
+    void releaseAdmission();
+    void detachBody();
+    void finish();
+    void onRequestDestroyed();
+    bool isRateLimited(const QString& _api);
+    void validateRequestHeaders();
+    void parseBufferedBody();
+    void callAPI(const QString& _api);
+    void pauseReading();
+    void resumeReading();
+    void probePausedReading();
+    void sendRejectResponse(qhttp::TStatusCode _code, const QByteArray& _body);
     QString toIPv4(const QString _ip);
+    void customEvent(QEvent* _event) Q_DECL_FINAL;
+    bool eventFilter(QObject* _watched, QEvent* _event) Q_DECL_FINAL;
 
 private:
     QByteArray                                          RemainingData;
-    qhttp::server::QHttpRequest*                        Request;
-    qhttp::server::QHttpResponse*                       Response;
+    QByteArray                                          ContentType;
+    qlonglong                                           ContentLength = -1;
+    qint64                                              MaxBodySize = 0;
+    qint64                                              ReceivedBytes = 0;
+    QSharedPointer<clsBodyStream>                       BodyStream;
+    bool                                                APIInvoked = false;
+    bool                                                BodyEnded = false;
+    bool                                                ReadingPaused = false;
+    bool                                                ResponseSent = false;
+    bool                                                ResultPending = false;
+    QPointer<qhttp::server::QHttpRequest>               Request;
+    QPointer<qhttp::server::QHttpResponse>              Response;
+    QPointer<QSocketNotifier>                           ReadNotifier;
+    QTimer*                                             PauseProbe = nullptr;
+    QElapsedTimer                                       PausedTimer;
     QScopedPointer<clsMultipartFormDataRequestHandler>  MultipartFormDataHandler;
+    clsAPIObject*                                       APIObject = nullptr;
+    QString                                             ExtraAPIPath;
+    PathArgs_t                                          PathArgs;
+    clsQueryArgs                                        BodyArgs;
+    QJsonObject                                         JSONBody;
+    bool                                                CountedInFlight = false;
+    bool                                                AcquiredAPISlot = false;
+
+    static QAtomicInt                                   InFlightRequests;
+
+    static QScopedPointer<clsAPIExecutor>               APIExecutor;
 
     friend class clsMultipartFormDataRequestHandler;
 };
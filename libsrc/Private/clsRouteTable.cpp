@@ -0,0 +1,247 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#include <algorithm>
+#include <string.h>
+#include "clsRouteTable.h"
+
+namespace QHttp {
+namespace Private {
+
+static constexpr quint32 NO_NODE = 0xFFFFFFFF;
+
+enuRouteSlot routeSlot(const QString& _method){
+    if(_method == "GET")    return ROUTE_GET;
+    if(_method == "POST")   return ROUTE_POST;
+    if(_method == "PUT")    return ROUTE_PUT;
+    if(_method == "PATCH")  return ROUTE_PATCH;
+    if(_method == "DELETE") return ROUTE_DELETE;
+    if(_method == "WS")     return ROUTE_WS;
+    return ROUTE_INVALID;
+}
+
+static inline int compareSegments(const QChar* _first, quint32 _firstSize, const QChar* _second, quint32 _secondSize){
+    if(_firstSize != _secondSize)
+        return _firstSize < _secondSize ? -1 : 1;
+    return memcmp(_first, _second, _firstSize * sizeof(QChar));
+}
+
+clsRouteTable::clsRouteTable()
+{
+    this->compile();
+}
+
+void clsRouteTable::add(enuRouteSlot _slot, const QString& _path, clsAPIObject* _apiObject)
+{
+    Q_ASSERT(_slot < ROUTE_SLOTS_COUNT);
+    this->Routes.push_back(stuRoute{_slot, _path, _apiObject});
+}
+
+void clsRouteTable::compile(ParamResolver_t _resolver)
+{
+    struct stuBuildNode{
+        std::vector<std::pair<QString, quint32>> Children;
+        quint32       ParamChild = NO_NODE;
+        clsAPIObject* APIs[ROUTE_SLOTS_COUNT] = {};
+        quint32       Templates[ROUTE_SLOTS_COUNT] = {};
+    };
+    std::vector<stuBuildNode> BuildNodes(1);
+
+    this->TemplateParams.assign(1, std::vector<qint8>());
+    for(const stuRoute& Route : this->Routes){
+        quint32 Node = 0;
+        std::vector<qint8> Params;
+        foreach(const QString& Segment, Route.Path.split('/', QString::SkipEmptyParts)){
+            quint32 Child = NO_NODE;
+            if(Segment.startsWith('{') && Segment.endsWith('}')){
+                /* Without resolver captures are bound to API parameters in order of appearance */
+                Params.push_back(_resolver ? _resolver(Route.APIObject, Segment.mid(1, Segment.size() - 2))
+                                           : static_cast<qint8>(Params.size()));
+                Child = BuildNodes[Node].ParamChild;
+                if(Child == NO_NODE){
+                    Child = static_cast<quint32>(BuildNodes.size());
+                    BuildNodes.emplace_back();
+                    BuildNodes[Node].ParamChild = Child;
+                }
+            }else{
+                for(const auto& Edge : BuildNodes[Node].Children)
+                    if(Edge.first == Segment){
+                        Child = Edge.second;
+                        break;
+                    }
+                if(Child == NO_NODE){
+                    Child = static_cast<quint32>(BuildNodes.size());
+                    BuildNodes.emplace_back();
+                    BuildNodes[Node].Children.emplace_back(Segment, Child);
+                }
+            }
+            Node = Child;
+        }
+        Q_ASSERT(Params.size() <= MAX_CAPTURES);
+        BuildNodes[Node].APIs[Route.Slot] = Route.APIObject;
+        if(Params.empty() == false){
+            BuildNodes[Node].Templates[Route.Slot] = static_cast<quint32>(this->TemplateParams.size());
+            this->TemplateParams.push_back(Params);
+        }
+    }
+
+    /* Flatten in BFS order so that children of each node are contiguous and sorted for binary search */
+    this->Nodes.clear();
+    this->Edges.clear();
+    this->Segments.clear();
+    this->Nodes.reserve(BuildNodes.size());
+    this->Edges.reserve(BuildNodes.size());
+
+    std::vector<quint32> Order(1, 0);
+    this->Nodes.push_back(stuNode());
+    for(size_t i = 0; i < Order.size(); ++i){
+        stuBuildNode& BuildNode = BuildNodes[Order[i]];
+        std::sort(BuildNode.Children.begin(), BuildNode.Children.end(), [](const std::pair<QString, quint32>& _first,
+                                                                           const std::pair<QString, quint32>& _second){
+            return compareSegments(_first.first.constData(), static_cast<quint32>(_first.first.size()),
+                                   _second.first.constData(), static_cast<quint32>(_second.first.size())) < 0;
+        });
+
+        stuNode& Node = this->Nodes[i];
+        std::copy_n(BuildNode.APIs, ROUTE_SLOTS_COUNT, Node.APIs);
+        std::copy_n(BuildNode.Templates, ROUTE_SLOTS_COUNT, Node.Templates);
+        Node.FirstEdge = static_cast<quint32>(this->Edges.size());
+        Node.EdgesCount = static_cast<quint32>(BuildNode.Children.size());
+        Node.ParamChild = NO_NODE;
+        for(const auto& Child : BuildNode.Children){
+            this->Edges.push_back(stuEdge{static_cast<quint32>(this->Segments.size()),
+                                          static_cast<quint32>(Child.first.size()),
+                                          static_cast<quint32>(Order.size())});
+            this->Segments.append(Child.first);
+            Order.push_back(Child.second);
+            this->Nodes.push_back(stuNode());
+        }
+        if(BuildNode.ParamChild != NO_NODE){
+            this->Nodes[i].ParamChild = static_cast<quint32>(Order.size());
+            Order.push_back(BuildNode.ParamChild);
+            this->Nodes.push_back(stuNode());
+        }
+    }
+}
+
+qint64 clsRouteTable::findChild(const stuNode& _node, const QChar* _segment, quint32 _size) const
+{
+    const QChar* SegmentsData = this->Segments.constData();
+    quint32 Low = _node.FirstEdge, High = _node.FirstEdge + _node.EdgesCount;
+    while(Low < High){
+        quint32 Middle = (Low + High) / 2;
+        const stuEdge& Edge = this->Edges[Middle];
+        int Result = compareSegments(SegmentsData + Edge.Offset, Edge.Size, _segment, _size);
+        if(Result == 0)
+            return Edge.Node;
+        if(Result < 0)
+            Low = Middle + 1;
+        else
+            High = Middle;
+    }
+    return -1;
+}
+
+bool clsRouteTable::match(quint32 _node, enuRouteSlot _slot, const QChar* _path, int _position, int _size, stuMatch& _match) const
+{
+    /* Segments are separated by exactly one slash so empty segments (as in `/module//api`) never match */
+    if(_position < _size && _path[_position] == '/')
+        ++_position;
+
+    const stuNode& Node = this->Nodes[_node];
+    if(_position >= _size){
+        if(Node.APIs[_slot] == nullptr)
+            return false;
+        _match.Node = _node;
+        return true;
+    }
+
+    int End = _position;
+    while(End < _size && _path[End] != '/')
+        ++End;
+    if(End == _position)
+        return false;
+
+    /* Exact segments are preferred over templates and templates are preferred over extra path */
+    qint64 Child = this->findChild(Node, _path + _position, static_cast<quint32>(End - _position));
+    if(Child >= 0 && this->match(static_cast<quint32>(Child), _slot, _path, End, _size, _match))
+        return true;
+
+    if(Node.ParamChild != NO_NODE && _match.CapturesCount < MAX_CAPTURES){
+        _match.Captures[_match.CapturesCount++] = stuSegment{_position, End - _position};
+        if(this->match(Node.ParamChild, _slot, _path, End, _size, _match))
+            return true;
+        --_match.CapturesCount;
+    }
+
+    /* Only the last segment can be served as extra path of its parent API */
+    if(End == _size && Node.APIs[_slot]){
+        _match.Node = _node;
+        _match.HasExtraPath = true;
+        _match.ExtraPath = stuSegment{_position, End - _position};
+        return true;
+    }
+    return false;
+}
+
+clsAPIObject* clsRouteTable::find(enuRouteSlot _slot, const QString& _path, QString* _extraPath, PathArgs_t* _pathArgs) const
+{
+    if(_slot >= ROUTE_SLOTS_COUNT)
+        return nullptr;
+
+    const QChar* Data = _path.constData();
+    /* One trailing slash is ignored so `/module/api/` and `/module/api/123/` are served as without it */
+    int Size = _path.size();
+    if(Size > 1 && Data[Size - 1] == '/')
+        --Size;
+
+    stuMatch Match;
+    Match.CapturesCount = 0;
+    Match.HasExtraPath = false;
+    if(this->match(0, _slot, Data, 0, Size, Match) == false)
+        return nullptr;
+
+    const stuNode& Node = this->Nodes[Match.Node];
+    QStringList Values;
+    if(Match.CapturesCount){
+        const std::vector<qint8>& Params = this->TemplateParams[Node.Templates[_slot]];
+        Q_ASSERT(Params.size() == Match.CapturesCount);
+        for(quint8 i = 0; i < Match.CapturesCount; ++i){
+            Values.append(QString(Data + Match.Captures[i].Start, Match.Captures[i].Size));
+            if(_pathArgs && Params[i] >= 0)
+                _pathArgs->append(stuPathArg{static_cast<quint8>(Params[i]), Values.last()});
+        }
+    }
+
+    if(_extraPath){
+        if(Match.HasExtraPath)
+            *_extraPath = QString(Data + Match.ExtraPath.Start, Match.ExtraPath.Size);
+        else if(Values.size())
+            /* Captured values are also provided as extra path to be compatible with `{pk1},{pk2}` form */
+            *_extraPath = Values.join(',');
+    }
+    return Node.APIs[_slot];
+}
+
+}
+}
@@ -0,0 +1,142 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#ifndef QHTTP_PRIVATE_CLSROUTETABLE_H
+#define QHTTP_PRIVATE_CLSROUTETABLE_H
+
+#include <vector>
+#include <QString>
+#include <QStringList>
+#include <QVarLengthArray>
+#include "QHttp/qhttpfwd.hpp"
+
+namespace QHttp {
+namespace Private {
+
+class clsAPIObject;
+
+/**
+ * @brief The enuRouteSlot enum maps HTTP methods accepted by APIs (and websocket) to a compact index used by clsRouteTable
+ */
+enum enuRouteSlot{
+    ROUTE_GET,
+    ROUTE_POST,
+    ROUTE_PUT,
+    ROUTE_PATCH,
+    ROUTE_DELETE,
+    ROUTE_WS,
+    ROUTE_SLOTS_COUNT,
+    ROUTE_INVALID = ROUTE_SLOTS_COUNT
+};
+
+inline enuRouteSlot routeSlot(qhttp::THttpMethod _method){
+    switch(_method){
+    case qhttp::EHTTP_GET:    return ROUTE_GET;
+    case qhttp::EHTTP_POST:   return ROUTE_POST;
+    case qhttp::EHTTP_PUT:    return ROUTE_PUT;
+    case qhttp::EHTTP_PATCH:  return ROUTE_PATCH;
+    case qhttp::EHTTP_DELETE: return ROUTE_DELETE;
+    default:                  return ROUTE_INVALID;
+    }
+}
+
+enuRouteSlot routeSlot(const QString& _method);
+
+/**
+ * @brief The stuPathArg struct is a value captured by a path template along with index of the API parameter it is bound to
+ */
+struct stuPathArg{
+    quint8  ParamIndex;
+    QString Value;
+};
+typedef QVarLengthArray<stuPathArg, 4> PathArgs_t;
+
+/**
+ * @brief ParamResolver_t maps name of a path template parameter to index of the API parameter bound to it or -1 when
+ *        the API has no parameter with that name
+ */
+typedef qint8 (*ParamResolver_t)(const clsAPIObject* _apiObject, const QString& _paramName);
+
+/**
+ * @brief The clsRouteTable class is an immutable segment trie compiled from registered APIs. Children of each node are
+ *        stored contiguously sorted by segment so lookups are binary searches on flat arrays and need no key building
+ *        nor allocation. Path templates such as `/account/{id}/orders/{orderId}` are stored as parameter children which
+ *        capture a whole segment and are resolved to API parameters on compile. When path is not found the API registered on its parent path will be returned and last
+ *        segment of the path will be reported as extra path.
+ */
+class clsRouteTable
+{
+public:
+    clsRouteTable();
+    void add(enuRouteSlot _slot, const QString& _path, clsAPIObject* _apiObject);
+    void compile(ParamResolver_t _resolver = nullptr);
+    clsAPIObject* find(enuRouteSlot _slot, const QString& _path, QString* _extraPath = nullptr, PathArgs_t* _pathArgs = nullptr) const;
+
+private:
+    static constexpr quint8 MAX_CAPTURES = 16;
+
+    struct stuNode{
+        quint32       FirstEdge;
+        quint32       EdgesCount;
+        quint32       ParamChild;
+        clsAPIObject* APIs[ROUTE_SLOTS_COUNT];
+        quint32       Templates[ROUTE_SLOTS_COUNT];
+    };
+    struct stuEdge{
+        quint32 Offset;
+        quint32 Size;
+        quint32 Node;
+    };
+    struct stuSegment{
+        int Start;
+        int Size;
+    };
+    struct stuMatch{
+        quint32    Node;
+        quint8     CapturesCount;
+        stuSegment Captures[MAX_CAPTURES];
+        bool       HasExtraPath;
+        stuSegment ExtraPath;
+    };
+
+    qint64 findChild(const stuNode& _node, const QChar* _segment, quint32 _size) const;
+    bool match(quint32 _node, enuRouteSlot _slot, const QChar* _path, int _position, int _size, stuMatch& _match) const;
+
+private:
+    std::vector<stuNode>            Nodes;
+    std::vector<stuEdge>            Edges;
+    std::vector<std::vector<qint8>> TemplateParams;
+    QString                         Segments;
+
+    struct stuRoute{
+        enuRouteSlot  Slot;
+        QString       Path;
+        clsAPIObject* APIObject;
+    };
+    std::vector<stuRoute> Routes;
+};
+
+}
+}
+
+#endif // QHTTP_PRIVATE_CLSROUTETABLE_H
@@ -0,0 +1,155 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <QTimer>
+#include "libTargomanCommon/Logger.h"
+#include "clsSocketHandoff.h"
+
+namespace QHttp {
+namespace Private {
+
+static constexpr int    HANDOFF_MAX_SOCKETS   = 64;
+static constexpr time_t HANDOFF_TIMEOUT_SECS  = 5;
+static constexpr char   HANDOFF_MAGIC         = 'H';
+
+clsSocketHandoff::clsSocketHandoff(const fnListeningSockets_t& _listeningSockets, const fnHandedOff_t& _onHandedOff) :
+    ListeningSockets(_listeningSockets),
+    OnHandedOff(_onHandedOff)
+{}
+
+bool clsSocketHandoff::listen(const QString& _path)
+{
+    QLocalServer::removeServer(_path);
+    this->setSocketOptions(QLocalServer::UserAccessOption);
+    if(QLocalServer::listen(_path) == false){
+        TargomanLogError("Unable to listen on handoff socket "<<_path<<": "<<this->errorString());
+        return false;
+    }
+    return true;
+}
+
+void clsSocketHandoff::incomingConnection(quintptr _handle)
+{
+    int Socket = static_cast<int>(_handle);
+    /* Close (and unlink) the handoff socket before sending so that the receiving process can bind the same path */
+    this->close();
+
+    QList<qintptr> Sockets = this->ListeningSockets().mid(0, HANDOFF_MAX_SOCKETS);
+    char Magic = HANDOFF_MAGIC;
+    iovec IOVector = { &Magic, sizeof(Magic) };
+    union {
+        char    Buffer[CMSG_SPACE(sizeof(int) * HANDOFF_MAX_SOCKETS)];
+        cmsghdr Align;
+    } Control;
+    memset(&Control, 0, sizeof(Control));
+
+    msghdr Message;
+    memset(&Message, 0, sizeof(Message));
+    Message.msg_iov = &IOVector;
+    Message.msg_iovlen = 1;
+
+    if(Sockets.size()){
+        Message.msg_control = Control.Buffer;
+        Message.msg_controllen = CMSG_SPACE(sizeof(int) * static_cast<size_t>(Sockets.size()));
+        cmsghdr* ControlHeader = CMSG_FIRSTHDR(&Message);
+        ControlHeader->cmsg_level = SOL_SOCKET;
+        ControlHeader->cmsg_type = SCM_RIGHTS;
+        ControlHeader->cmsg_len = CMSG_LEN(sizeof(int) * static_cast<size_t>(Sockets.size()));
+        int* Descriptors = reinterpret_cast<int*>(CMSG_DATA(ControlHeader));
+        for(int i = 0; i < Sockets.size(); ++i)
+            Descriptors[i] = static_cast<int>(Sockets.at(i));
+    }
+
+    bool Sent = ::sendmsg(Socket, &Message, MSG_NOSIGNAL) == sizeof(Magic);
+    if(Sent == false)
+        TargomanLogError("Unable to hand off listening sockets: "<<strerror(errno));
+    ::close(Socket);
+
+    if(Sent){
+        TargomanLogInfo(1, Sockets.size()<<" listening socket(s) were handed off to the new process");
+        QTimer::singleShot(0, this->OnHandedOff);
+    }
+}
+
+QList<qintptr> clsSocketHandoff::receive(const QString& _path)
+{
+    QByteArray Path = _path.toLocal8Bit();
+    sockaddr_un Address;
+    memset(&Address, 0, sizeof(Address));
+    if(static_cast<size_t>(Path.size()) >= sizeof(Address.sun_path))
+        return {};
+    Address.sun_family = AF_UNIX;
+    memcpy(Address.sun_path, Path.constData(), static_cast<size_t>(Path.size()));
+
+    int Socket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(Socket < 0)
+        return {};
+
+    timeval Timeout = { HANDOFF_TIMEOUT_SECS, 0 };
+    ::setsockopt(Socket, SOL_SOCKET, SO_RCVTIMEO, &Timeout, sizeof(Timeout));
+    if(::connect(Socket, reinterpret_cast<sockaddr*>(&Address), sizeof(Address))){
+        /* No older process is serving the handoff socket */
+        ::close(Socket);
+        return {};
+    }
+
+    char Magic = 0;
+    iovec IOVector = { &Magic, sizeof(Magic) };
+    union {
+        char    Buffer[CMSG_SPACE(sizeof(int) * HANDOFF_MAX_SOCKETS)];
+        cmsghdr Align;
+    } Control;
+    msghdr Message;
+    memset(&Message, 0, sizeof(Message));
+    Message.msg_iov = &IOVector;
+    Message.msg_iovlen = 1;
+    Message.msg_control = Control.Buffer;
+    Message.msg_controllen = sizeof(Control.Buffer);
+
+    QList<qintptr> Sockets;
+    ssize_t Received = ::recvmsg(Socket, &Message, MSG_CMSG_CLOEXEC);
+    ::close(Socket);
+
+    if(Received != sizeof(Magic) || Magic != HANDOFF_MAGIC){
+        TargomanLogWarn(1, "Invalid response received from handoff socket "<<_path);
+        return {};
+    }
+
+    for(cmsghdr* ControlHeader = CMSG_FIRSTHDR(&Message); ControlHeader; ControlHeader = CMSG_NXTHDR(&Message, ControlHeader)){
+        if(ControlHeader->cmsg_level != SOL_SOCKET || ControlHeader->cmsg_type != SCM_RIGHTS)
+            continue;
+        size_t Count = (ControlHeader->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const int* Descriptors = reinterpret_cast<const int*>(CMSG_DATA(ControlHeader));
+        for(size_t i = 0; i < Count; ++i)
+            Sockets.append(Descriptors[i]);
+    }
+    return Sockets;
+}
+
+}
+}
@@ -0,0 +1,59 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#ifndef QHTTP_PRIVATE_CLSSOCKETHANDOFF_H
+#define QHTTP_PRIVATE_CLSSOCKETHANDOFF_H
+
+#include <functional>
+#include <QLocalServer>
+
+namespace QHttp {
+namespace Private {
+
+typedef std::function<QList<qintptr>()> fnListeningSockets_t;
+typedef std::function<void()>           fnHandedOff_t;
+
+/**
+ * @brief The clsSocketHandoff class listens on a Unix domain socket and passes all listening sockets of the server to the
+ *        first process connecting to it using SCM_RIGHTS. A newer process calls receive"()" before listening so that it can
+ *        adopt the very same sockets (and their pending accept queues) instead of binding new ones.
+ */
+class clsSocketHandoff : public QLocalServer{
+public:
+    clsSocketHandoff(const fnListeningSockets_t& _listeningSockets, const fnHandedOff_t& _onHandedOff);
+
+    bool listen(const QString& _path);
+    static QList<qintptr> receive(const QString& _path);
+
+protected:
+    void incomingConnection(quintptr _handle) Q_DECL_FINAL;
+
+private:
+    fnListeningSockets_t ListeningSockets;
+    fnHandedOff_t        OnHandedOff;
+};
+
+}
+}
+
+#endif // QHTTP_PRIVATE_CLSSOCKETHANDOFF_H
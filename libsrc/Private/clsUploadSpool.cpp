@@ -0,0 +1,276 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include "clsUploadSpool.h"
+#include "clsUploadStorage.h"
+#include "Configs.hpp"
+
+namespace QHttp {
+namespace Private {
+
+static constexpr int SPOOL_WRITE_SIZE = 256 * 1024;
+
+/* Spools of the request whose API is running on this thread */
+static thread_local const QList<QSharedPointer<clsUploadSpool>>* CurrentSpools = nullptr;
+
+static const char* digestName(QCryptographicHash::Algorithm _algorithm)
+{
+    switch(_algorithm){
+    case QCryptographicHash::Md4:       return "md4";
+    case QCryptographicHash::Md5:       return "md5";
+    case QCryptographicHash::Sha1:      return "sha1";
+    case QCryptographicHash::Sha224:    return "sha224";
+    case QCryptographicHash::Sha256:    return "sha256";
+    case QCryptographicHash::Sha384:    return "sha384";
+    case QCryptographicHash::Sha512:    return "sha512";
+    case QCryptographicHash::Sha3_224:  return "sha3-224";
+    case QCryptographicHash::Sha3_256:  return "sha3-256";
+    case QCryptographicHash::Sha3_384:  return "sha3-384";
+    case QCryptographicHash::Sha3_512:  return "sha3-512";
+    default:                            return "unknown";
+    }
+}
+
+clsUploadSpool::clsUploadSpool(qint64 _memoryThreshold, const QList<QCryptographicHash::Algorithm>& _digests) :
+    MemoryThreshold(_memoryThreshold),
+    Size(0),
+    SpooledBytes(0),
+    FD(-1),
+    Duplicate(false),
+    DigestAlgorithms(_digests)
+{
+    foreach(auto Algorithm, _digests)
+        this->Digests.append(QSharedPointer<QCryptographicHash>(new QCryptographicHash(Algorithm)));
+
+    quint32 Random[4];
+    QRandomGenerator::system()->fillRange(Random);
+    this->Id = QString::fromLatin1(QByteArray(reinterpret_cast<const char*>(Random), sizeof(Random)).toHex());
+}
+
+clsUploadSpool::~clsUploadSpool()
+{
+    /* Spool files are released on cleanup thread as closing large files may block */
+    if(this->FD >= 0)
+        clsUploadStorage::discard(this->FD, this->SpooledBytes);
+}
+
+void clsUploadSpool::write(const char* _buffer, size_t _size)
+{
+    this->Size += static_cast<qint64>(_size);
+    foreach(auto Digest, this->Digests)
+        Digest->addData(_buffer, static_cast<int>(_size));
+
+    if(this->FD < 0){
+        if(this->Size <= this->MemoryThreshold){
+            this->Data.append(_buffer, static_cast<int>(_size));
+            return;
+        }
+        this->reserve(this->Size);
+        this->openFile(gConfigs.Public.UploadDirectory.isEmpty() ? QDir::tempPath() : gConfigs.Public.UploadDirectory);
+        this->Data.reserve(SPOOL_WRITE_SIZE);
+    }else
+        this->reserve(static_cast<qint64>(_size));
+
+    /* Data is used as write buffer when spooling so writes are issued in large blocks */
+    if(this->Data.isEmpty() && _size >= static_cast<size_t>(SPOOL_WRITE_SIZE))
+        return this->writeAll(_buffer, _size);
+
+    this->Data.append(_buffer, static_cast<int>(_size));
+    if(this->Data.size() >= SPOOL_WRITE_SIZE)
+        this->flush();
+}
+
+void clsUploadSpool::finish()
+{
+    if(this->FD < 0)
+        return;
+    this->flush();
+    this->Data.squeeze();
+    ::lseek(this->FD, 0, SEEK_SET);
+}
+
+QString clsUploadSpool::path() const
+{
+    return this->FD < 0 ? QString() : QString("/proc/self/fd/%1").arg(this->FD);
+}
+
+QByteArray clsUploadSpool::digest(QCryptographicHash::Algorithm _algorithm) const
+{
+    int Index = this->DigestAlgorithms.indexOf(_algorithm);
+    return Index < 0 ? QByteArray() : this->Digests.at(Index)->result();
+}
+
+QVariantMap clsUploadSpool::digests() const
+{
+    QVariantMap Digests;
+    for(int i=0; i<this->DigestAlgorithms.size(); ++i)
+        Digests.insert(digestName(this->DigestAlgorithms.at(i)), QString::fromLatin1(this->Digests.at(i)->result().toHex()));
+    return Digests;
+}
+
+void clsUploadSpool::store(const QString& _storeDirectory)
+{
+    QByteArray Hash = this->digest(QCryptographicHash::Sha256).toHex();
+    if(Hash.isEmpty())
+        throw exHTTPInternalServerError("SHA-256 digest is required to store uploaded files");
+
+    QString Directory = _storeDirectory + "/" + QString::fromLatin1(Hash.left(2));
+    this->StoredPath = Directory + "/" + QString::fromLatin1(Hash.mid(2));
+    if(QFile::exists(this->StoredPath)){
+        this->Duplicate = true;
+        return;
+    }
+    if(QDir().mkpath(Directory) == false)
+        throw exHTTPInternalServerError("Unable to create upload store directory: " + Directory);
+
+    if(this->FD < 0){
+        /* In-memory spools were not counted by the storage quota until they are written to a file */
+        this->reserve(this->Size);
+        this->openFile(Directory);
+        this->writeAll(this->Data.constData(), static_cast<size_t>(this->Data.size()));
+        this->Data.clear();
+    }
+
+    /* Linking is atomic so concurrent uploads of the same content will end with a single stored copy */
+    QByteArray Target = QFile::encodeName(this->StoredPath);
+    if(::linkat(AT_FDCWD, QFile::encodeName(this->path()).constData(), AT_FDCWD, Target.constData(), AT_SYMLINK_FOLLOW) == 0)
+        return;
+    if(errno == EEXIST){
+        this->Duplicate = true;
+        return;
+    }
+
+    /* Spool on another filesystem (or without O_TMPFILE support) must be copied and then renamed into the store */
+    QString TempPath = QString("%1.%2.%3").arg(this->StoredPath).arg(::getpid()).arg(reinterpret_cast<quintptr>(this), 0, 16);
+    if(QFile::copy(this->path(), TempPath) == false ||
+       ::rename(QFile::encodeName(TempPath).constData(), Target.constData()) != 0){
+        QFile::remove(TempPath);
+        throw exHTTPInternalServerError("Unable to store uploaded file on: " + this->StoredPath);
+    }
+}
+
+void clsUploadSpool::reserve(qint64 _bytes)
+{
+    if(clsUploadStorage::reserve(_bytes) == false)
+        throw exHTTPInsufficientStorage("Upload storage quota exceeded");
+    this->SpooledBytes += _bytes;
+}
+
+void clsUploadSpool::openFile(const QString& _directory)
+{
+    QByteArray Dir = QFile::encodeName(_directory);
+#ifdef O_TMPFILE
+    this->FD = ::open(Dir.constData(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    if(this->FD >= 0)
+        return clsUploadStorage::fileOpened();
+#endif
+    /* Filesystems without O_TMPFILE support get a named file which is unlinked at once */
+    QByteArray Template = Dir + "/qhttp-upload-XXXXXX";
+    this->FD = ::mkostemp(Template.data(), O_CLOEXEC);
+    if(this->FD < 0)
+        throw exHTTPInternalServerError(QString("Unable to create upload spool file: %1").arg(strerror(errno)));
+    ::unlink(Template.constData());
+    clsUploadStorage::fileOpened();
+}
+
+void clsUploadSpool::writeAll(const char* _buffer, size_t _size)
+{
+    while(_size){
+        ssize_t Written = ::write(this->FD, _buffer, _size);
+        if(Written < 0){
+            if(errno == EINTR)
+                continue;
+            throw exHTTPInternalServerError(QString("Unable to write upload spool file: %1").arg(strerror(errno)));
+        }
+        _buffer += Written;
+        _size -= static_cast<size_t>(Written);
+    }
+}
+
+void clsUploadSpool::flush()
+{
+    if(this->Data.size())
+        this->writeAll(this->Data.constData(), static_cast<size_t>(this->Data.size()));
+    this->Data.resize(0);
+}
+
+void clsUploadSpool::claim(const QVariantMap& _file, const QString& _destination)
+{
+    QString Id = _file.value("id").toString();
+    clsUploadSpool* Spool = nullptr;
+    if(CurrentSpools && Id.size())
+        foreach(auto RequestSpool, *CurrentSpools)
+            if(RequestSpool->id() == Id){
+                Spool = RequestSpool.data();
+                break;
+            }
+    if(Spool == nullptr)
+        throw exHTTPBadRequest("Invalid uploaded file info");
+
+    QByteArray Destination = QFile::encodeName(_destination);
+
+    if(Spool->storedPath().size()){
+        /* Stored path is set by store"()" but is checked to be in the store as files out of it must not be exposed */
+        QString StoreDirectory = QDir::cleanPath(QFileInfo(gConfigs.Public.UploadStoreDirectory).absoluteFilePath()) + "/";
+        if(gConfigs.Public.UploadStoreDirectory.isEmpty() ||
+           QDir::cleanPath(QFileInfo(Spool->storedPath()).absoluteFilePath()).startsWith(StoreDirectory) == false)
+            throw exHTTPInternalServerError("Uploaded file is not kept on upload store");
+        if(::link(QFile::encodeName(Spool->storedPath()).constData(), Destination.constData()) == 0 ||
+           QFile::copy(Spool->storedPath(), _destination))
+            return;
+    }else if(Spool->inMemory()){
+        QFile File(_destination);
+        if(File.open(QIODevice::WriteOnly) && File.write(Spool->data()) == Spool->data().size())
+            return;
+    }else{
+        /* Anonymous files are linked on the same filesystem and copied otherwise */
+        if(::linkat(AT_FDCWD, QFile::encodeName(Spool->path()).constData(), AT_FDCWD, Destination.constData(), AT_SYMLINK_FOLLOW) == 0 ||
+           QFile::copy(Spool->path(), _destination))
+            return;
+    }
+
+    throw exHTTPInternalServerError("Unable to store uploaded file to: " + _destination);
+}
+
+clsUploadSpool::stuClaimScope::stuClaimScope(const QList<QSharedPointer<clsUploadSpool>>& _spools) :
+    Previous(CurrentSpools)
+{
+    CurrentSpools = &_spools;
+}
+
+clsUploadSpool::stuClaimScope::~stuClaimScope()
+{
+    CurrentSpools = this->Previous;
+}
+
+}
+}
@@ -0,0 +1,116 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#ifndef QHTTP_PRIVATE_CLSUPLOADSPOOL_H
+#define QHTTP_PRIVATE_CLSUPLOADSPOOL_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVariantMap>
+#include <QCryptographicHash>
+#include <QSharedPointer>
+
+namespace QHttp {
+namespace Private {
+
+/**
+ * @brief The clsUploadSpool class stores content of an uploaded file part. Parts are kept in memory until they exceed the
+ *        configured threshold and then are spooled to an anonymous O_TMPFILE file on the upload directory using large
+ *        buffered writes. Anonymous files vanish when the last owner of the spool (the request handler or the API
+ *        invocation using it) is gone unless the API claims them by claim"()" which links them to their destination
+ *        without copying. Requested digests are computed while data is being written so APIs and the content-addressed
+ *        store do not need to read the file again.
+ */
+class clsUploadSpool
+{
+public:
+    clsUploadSpool(qint64 _memoryThreshold, const QList<QCryptographicHash::Algorithm>& _digests = {});
+    ~clsUploadSpool();
+
+    void write(const char* _buffer, size_t _size);
+    void finish();
+
+    /**
+     * @brief id returns a random opaque identifier passed to APIs in file info by which the file can be claimed
+     */
+    inline const QString& id() const { return this->Id; }
+    inline bool inMemory() const { return this->FD < 0; }
+    inline const QByteArray& data() const { return this->Data; }
+    inline qint64 size() const { return this->Size; }
+    /**
+     * @brief path returns the /proc/self/fd path of the spool file which is valid only while the spool is alive
+     */
+    QString path() const;
+
+    QByteArray digest(QCryptographicHash::Algorithm _algorithm) const;
+    QVariantMap digests() const;
+
+    /**
+     * @brief store links content to _storeDirectory/xx/yyy... named by its SHA-256 digest. When the same content is already
+     *        stored nothing is written and the file is marked as duplicate
+     */
+    void store(const QString& _storeDirectory);
+    inline const QString& storedPath() const { return this->StoredPath; }
+    inline bool duplicate() const { return this->Duplicate; }
+
+    /**
+     * @brief claim stores the uploaded file identified by id of _file (as passed to APIs) on _destination. The file is
+     *        looked up just in spools of the request whose API is running on current thread so file info sent by clients
+     *        can not refer to other files
+     */
+    static void claim(const QVariantMap& _file, const QString& _destination);
+
+    /**
+     * @brief The stuClaimScope struct makes spools of a request claimable by the API invoked in its scope on current thread
+     */
+    struct stuClaimScope{
+        stuClaimScope(const QList<QSharedPointer<clsUploadSpool>>& _spools);
+        ~stuClaimScope();
+    private:
+        const QList<QSharedPointer<clsUploadSpool>>* Previous;
+    };
+
+private:
+    void reserve(qint64 _bytes);
+    void openFile(const QString& _directory);
+    void writeAll(const char* _buffer, size_t _size);
+    void flush();
+
+private:
+    qint64      MemoryThreshold;
+    qint64      Size;
+    qint64      SpooledBytes;
+    int         FD;
+    QString     Id;
+    QByteArray  Data;
+    QString     StoredPath;
+    bool        Duplicate;
+
+    QList<QCryptographicHash::Algorithm>    DigestAlgorithms;
+    QList<QSharedPointer<QCryptographicHash>> Digests;
+};
+
+}
+}
+
+#endif // QHTTP_PRIVATE_CLSUPLOADSPOOL_H
@@ -0,0 +1,129 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#include <unistd.h>
+#include "clsUploadStorage.h"
+#include "Configs.hpp"
+
+namespace QHttp {
+namespace Private {
+
+QAtomicInteger<qint64>                  clsUploadStorage::SpooledBytes;
+QAtomicInt                              clsUploadStorage::SpooledFiles;
+QAtomicInteger<quint64>                 clsUploadStorage::Rejected;
+QMutex                                  clsUploadStorage::Lock;
+QWaitCondition                          clsUploadStorage::HasPending;
+QVector<clsUploadStorage::stuPendingFile> clsUploadStorage::Pending;
+clsUploadStorage::clsCleanupThread*     clsUploadStorage::Cleaner = nullptr;
+bool                                    clsUploadStorage::Stopping = false;
+
+bool clsUploadStorage::reserve(qint64 _bytes)
+{
+    qint64 Used = clsUploadStorage::SpooledBytes.fetchAndAddOrdered(_bytes) + _bytes;
+    if(gConfigs.Public.MaxSpooledUploadBytes && Used > gConfigs.Public.MaxSpooledUploadBytes){
+        clsUploadStorage::SpooledBytes.fetchAndAddOrdered(-_bytes);
+        clsUploadStorage::Rejected.fetchAndAddOrdered(1);
+        return false;
+    }
+    return true;
+}
+
+void clsUploadStorage::fileOpened()
+{
+    clsUploadStorage::SpooledFiles.fetchAndAddOrdered(1);
+}
+
+void clsUploadStorage::discard(int _fd, qint64 _bytes)
+{
+    QMutexLocker Locker(&clsUploadStorage::Lock);
+    if(clsUploadStorage::Stopping){
+        Locker.unlock();
+        return clsUploadStorage::release({_fd, _bytes});
+    }
+
+    clsUploadStorage::Pending.append({_fd, _bytes});
+    if(clsUploadStorage::Cleaner == nullptr){
+        clsUploadStorage::Cleaner = new clsCleanupThread;
+        clsUploadStorage::Cleaner->start(QThread::LowPriority);
+    }
+    clsUploadStorage::HasPending.wakeOne();
+}
+
+void clsUploadStorage::stop()
+{
+    clsCleanupThread* Cleaner;
+    {
+        QMutexLocker Locker(&clsUploadStorage::Lock);
+        Cleaner = clsUploadStorage::Cleaner;
+        clsUploadStorage::Cleaner = nullptr;
+        clsUploadStorage::Stopping = true;
+        clsUploadStorage::HasPending.wakeAll();
+    }
+    if(Cleaner){
+        Cleaner->wait();
+        delete Cleaner;
+    }
+
+    QMutexLocker Locker(&clsUploadStorage::Lock);
+    clsUploadStorage::Stopping = false;
+}
+
+stuUploadStorageStatistics clsUploadStorage::stats()
+{
+    stuUploadStorageStatistics Stats;
+    Stats.SpooledBytes = clsUploadStorage::SpooledBytes.loadAcquire();
+    Stats.SpooledFiles = static_cast<quint32>(clsUploadStorage::SpooledFiles.loadAcquire());
+    Stats.Rejected = clsUploadStorage::Rejected.loadAcquire();
+    QMutexLocker Locker(&clsUploadStorage::Lock);
+    Stats.PendingCleanup = static_cast<quint32>(clsUploadStorage::Pending.size());
+    return Stats;
+}
+
+void clsUploadStorage::release(const stuPendingFile& _file)
+{
+    ::close(_file.FD);
+    clsUploadStorage::SpooledBytes.fetchAndAddOrdered(-_file.Bytes);
+    clsUploadStorage::SpooledFiles.fetchAndAddOrdered(-1);
+}
+
+void clsUploadStorage::clsCleanupThread::run()
+{
+    QVector<stuPendingFile> Files;
+    forever{
+        {
+            QMutexLocker Locker(&clsUploadStorage::Lock);
+            while(clsUploadStorage::Pending.isEmpty() && clsUploadStorage::Stopping == false)
+                clsUploadStorage::HasPending.wait(&clsUploadStorage::Lock);
+            if(clsUploadStorage::Pending.isEmpty())
+                return;
+            Files.swap(clsUploadStorage::Pending);
+        }
+        /* Files are closed out of lock so discarding is never blocked by the filesystem */
+        foreach(const stuPendingFile& File, Files)
+            clsUploadStorage::release(File);
+        Files.clear();
+    }
+}
+
+}
+}
@@ -0,0 +1,76 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#ifndef QHTTP_PRIVATE_CLSUPLOADSTORAGE_H
+#define QHTTP_PRIVATE_CLSUPLOADSTORAGE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include "QHttp/GenericTypes.h"
+
+namespace QHttp {
+namespace Private {
+
+/**
+ * @brief The clsUploadStorage class accounts disk space used by upload spool files against the global quota and closes
+ *        files of finished requests on a background thread, as releasing large files can stall the event loop.
+ */
+class clsUploadStorage
+{
+public:
+    static bool reserve(qint64 _bytes);
+    static void fileOpened();
+    static void discard(int _fd, qint64 _bytes);
+    static void stop();
+    static stuUploadStorageStatistics stats();
+
+private:
+    struct stuPendingFile{
+        int     FD;
+        qint64  Bytes;
+    };
+
+    class clsCleanupThread : public QThread{
+    private:
+        void run() Q_DECL_FINAL;
+    };
+
+    static void release(const stuPendingFile& _file);
+
+private:
+    static QAtomicInteger<qint64>   SpooledBytes;
+    static QAtomicInt               SpooledFiles;
+    static QAtomicInteger<quint64>  Rejected;
+    static QMutex                   Lock;
+    static QWaitCondition           HasPending;
+    static QVector<stuPendingFile>  Pending;
+    static clsCleanupThread*        Cleaner;
+    static bool                     Stopping;
+};
+
+}
+}
+
+#endif // QHTTP_PRIVATE_CLSUPLOADSTORAGE_H
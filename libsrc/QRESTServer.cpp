@@ -22,15 +22,22 @@
  */
 
 #include <QThread>
+#include <QElapsedTimer>
+#include <QCoreApplication>
 #include <QTcpSocket>
 #include <QtConcurrent/QtConcurrent>
 #include "QRESTServer.h"
 #include "Private/Configs.hpp"
 #include "Private/clsRequestHandler.h"
+#include "Private/clsIOThread.h"
 #include "Private/clsRedisConnector.h"
 #include "Private/WebSocketServer.hpp"
 #include "Private/RESTAPIRegistry.h"
 #include "Private/QJWT.h"
+#include "Private/clsIPBlockList.h"
+#include "Private/clsUploadSpool.h"
+#include "Private/clsUploadStorage.h"
+#include "Private/clsSocketHandoff.h"
 #include "QHttp/qhttpfwd.hpp"
 
 namespace QHttp {
@@ -40,15 +47,19 @@ using namespace qhttp::server;
 using namespace Private;
 
 bool validateConnection(const QHostAddress& _peerAddress, quint16 _peerPort){
-    enuIPBlackListStatus::Type IPBlackListStatus = enuIPBlackListStatus::Unknown;
+    enuIPBlackListStatus::Type IPBlackListStatus = clsIPBlockList::status(_peerAddress);
 
-    if(gConfigs.Public.fnIPInBlackList &&
-            (IPBlackListStatus = gConfigs.Public.fnIPInBlackList(_peerAddress)) != enuIPBlackListStatus::Ok){
+    if(IPBlackListStatus == enuIPBlackListStatus::Unknown && gConfigs.Public.fnIPInBlackList == false)
+        IPBlackListStatus = enuIPBlackListStatus::Ok;
+    else if(IPBlackListStatus == enuIPBlackListStatus::Unknown)
+        IPBlackListStatus = gConfigs.Public.fnIPInBlackList(_peerAddress);
+
+    if(IPBlackListStatus != enuIPBlackListStatus::Ok){
         TargomanLogWarn(1,"Connection from " + _peerAddress.toString() + " was closed by security provider due to: "+enuIPBlackListStatus::toStr(IPBlackListStatus));
-        gServerStats.Blocked.inc();
+        incServerStat(gServerStats.Blocked);
         return false;
     }
-    gServerStats.Connections.inc();
+    incServerStat(gServerStats.Connections);
 
     TargomanLogInfo(7, "New connection accepted from: "<<_peerAddress.toString()<<":"<<_peerPort);
     return true;
@@ -61,11 +72,57 @@ void RESTServer::configure(const RESTServer::stuConfig& _configs) {
     gConfigs.Public = _configs;
 }
 
-static qhttp::server::QHttpServer gHTTPServer;
+static void onNewConnection(QHttpConnection* _con){
+    if(!validateConnection (_con->tcpSocket()->peerAddress(), _con->tcpSocket()->peerPort()))
+        _con->killConnection();
+}
+
+static void onNewRequest(QHttpRequest* _req, QHttpResponse* _res){
+    clsRequestHandler* RequestHandler = new clsRequestHandler(_req, _res);
+    try{
+        QString Path = _req->url().adjusted(QUrl::NormalizePathSegments |
+                                            QUrl::RemoveAuthority
+                                            ).path(QUrl::PrettyDecoded);
+
+        if(Path.startsWith(gConfigs.Public.BasePath) == false)
+            return RequestHandler->sendError(qhttp::ESTATUS_NOT_FOUND, "Path not found: '" + Path + "'", true);
+        if(Path.startsWith(gConfigs.Private.BasePathWithVersion) == false)
+            return RequestHandler->sendError(qhttp::ESTATUS_NOT_ACCEPTABLE, "Invalid Version or version not specified", true);
+        if(Path == gConfigs.Private.BasePathWithVersion )
+            return RequestHandler->sendError(qhttp::ESTATUS_NOT_ACCEPTABLE, "No API call provided", true);
+
+        TargomanLogInfo(7,
+                        "New API Call ["<<
+                        _req->connection()->tcpSocket()->peerAddress().toString()<<
+                        ":"<<
+                        _req->connection()->tcpSocket()->peerPort()<<
+                        "]: "<<
+                        Path<<
+                        "?"<<
+                        _req->url().query());
+        RequestHandler->process(Path.mid(gConfigs.Private.BasePathWithVersion.size() - 1));
+    }catch(exTargomanBase& ex){
+        RequestHandler->sendError(static_cast<qhttp::TStatusCode>(ex.httpCode()), ex.what(), ex.httpCode() >= 500);
+    }
+}
+
+static QScopedPointer<clsHTTPListener> gHTTPListener;
+static QList<clsIOThread*> gIOThreads;
 #ifdef QHTTP_ENABLE_WEBSOCKET
 static WebSocketServer gWSServer;
 #endif
 static clsUpdateAndPruneThread *gStatUpdateThread;
+static QScopedPointer<clsSocketHandoff> gSocketHandoff;
+
+static QList<qintptr> listeningSockets(){
+    QList<qintptr> Sockets;
+    if(gHTTPListener.isNull() == false && gHTTPListener->isListening())
+        Sockets.append(gHTTPListener->socketDescriptor());
+    foreach(clsIOThread* IOThread, gIOThreads)
+        if(IOThread->listeningSocket() >= 0)
+            Sockets.append(IOThread->listeningSocket());
+    return Sockets;
+}
 
 void RESTServer::start() {
     if(gConfigs.Private.IsStarted)
@@ -92,6 +149,11 @@ void RESTServer::start() {
     if(gConfigs.Private.BasePathWithVersion.endsWith('/') == false)
         gConfigs.Private.BasePathWithVersion += '/';
 
+    RESTAPIRegistry::compileRoutes();
+
+    if(gConfigs.Public.IPBlockListFile.size())
+        TargomanLogInfo(1, RESTServer::reloadIPBlockList()<<" prefixes loaded from "<<gConfigs.Public.IPBlockListFile);
+
     gConfigs.Private.IsStarted = true;
 
     if(gConfigs.Public.StatisticsInterval){
@@ -100,48 +162,46 @@ void RESTServer::start() {
         gStatUpdateThread->start();
     }
 
+    clsRequestHandler::startAPIWorkers(gConfigs.Public.APIWorkerThreads);
+
+    QList<qintptr> HandedOffSockets;
+    if(gConfigs.Public.HandoffSocketPath.size()){
+        HandedOffSockets = clsSocketHandoff::receive(gConfigs.Public.HandoffSocketPath);
+        if(HandedOffSockets.size())
+            TargomanLogInfo(1, HandedOffSockets.size()<<" listening socket(s) adopted from previous process");
+    }
 
-    QObject::connect(&gHTTPServer, &QHttpServer::newConnection, [](QHttpConnection* _con){
-        if(!validateConnection (_con->tcpSocket()->peerAddress(), _con->tcpSocket()->peerPort()))
-            _con->killConnection();
-    });
-
-    gHTTPServer.listen (gConfigs.Public.ListenAddress, gConfigs.Public.ListenPort, [&](QHttpRequest* _req, QHttpResponse* _res){
-        clsRequestHandler* RequestHandler = new clsRequestHandler(_req, _res);
-        try{
-            QString Path = _req->url().adjusted(QUrl::NormalizePathSegments |
-                                                QUrl::RemoveAuthority
-                                                ).path(QUrl::PrettyDecoded);
-
-            if(Path.startsWith(gConfigs.Public.BasePath) == false)
-                return RequestHandler->sendError(qhttp::ESTATUS_NOT_FOUND, "Path not found: '" + Path + "'", true);
-            if(Path.startsWith(gConfigs.Private.BasePathWithVersion) == false)
-                return RequestHandler->sendError(qhttp::ESTATUS_NOT_ACCEPTABLE, "Invalid Version or version not specified", true);
-            if(Path == gConfigs.Private.BasePathWithVersion )
-                return RequestHandler->sendError(qhttp::ESTATUS_NOT_ACCEPTABLE, "No API call provided", true);
-
-            TargomanLogInfo(7,
-                            "New API Call ["<<
-                            _req->connection()->tcpSocket()->peerAddress().toString()<<
-                            ":"<<
-                            _req->connection()->tcpSocket()->peerPort()<<
-                            "]: "<<
-                            Path<<
-                            "?"<<
-                            _req->url().query());
-            RequestHandler->process(Path.mid(gConfigs.Private.BasePathWithVersion.size() - 1));
-        }catch(exTargomanBase& ex){
-            RequestHandler->sendError(static_cast<qhttp::TStatusCode>(ex.httpCode()), ex.what(), ex.httpCode() >= 500);
+    bool IsListening = true;
+    int ListenersCount = qMax(static_cast<int>(gConfigs.Public.IOThreads), HandedOffSockets.size());
+    if(ListenersCount > 1){
+        for(int i = 0; i < ListenersCount && IsListening; ++i){
+            gIOThreads.append(new clsIOThread(onNewConnection, onNewRequest, i < HandedOffSockets.size() ? HandedOffSockets.at(i) : -1));
+            IsListening = gIOThreads.last()->startListening();
         }
-    });
+    }else{
+        gHTTPListener.reset(new clsHTTPListener(onNewConnection, onNewRequest));
+        if(HandedOffSockets.size())
+            IsListening = gHTTPListener->adoptSocket(HandedOffSockets.first());
+        else
+            IsListening = gHTTPListener->listenReusePort(gConfigs.Public.ListenAddress, gConfigs.Public.ListenPort);
+    }
 
-    if(gHTTPServer.isListening()){
-        TargomanLogInfo(1, "REST Server is listening on "<<gConfigs.Public.ListenAddress.toString()<<":"<<gConfigs.Public.ListenPort);
+    if(IsListening){
+        TargomanLogInfo(1, "REST Server is listening on "<<gConfigs.Public.ListenAddress.toString()<<":"<<gConfigs.Public.ListenPort<<
+                        " using "<<qMax(ListenersCount, 1)<<" IO thread(s)");
     }else{
         TargomanLogError("Unable to start server to listen on "<<gConfigs.Public.ListenAddress.toString()<<":"<<gConfigs.Public.ListenPort);
         exit (1);
     }
 
+    if(gConfigs.Public.HandoffSocketPath.size()){
+        gSocketHandoff.reset(new clsSocketHandoff(listeningSockets, [](){
+            RESTServer::drain(gConfigs.Public.DrainTimeoutMSecs);
+            QCoreApplication::quit();
+        }));
+        gSocketHandoff->listen(gConfigs.Public.HandoffSocketPath);
+    }
+
 #ifdef QHTTP_ENABLE_WEBSOCKET
     if(gConfigs.Public.WebSocketServerName.size()){
         QObject::connect(&gWSServer, &WebSocketServer::sigNewConnection, [](QWebSocket* _con){
@@ -156,19 +216,79 @@ void RESTServer::start() {
 
 void RESTServer::stop()
 {
-    gHTTPServer.stopListening();
+    gSocketHandoff.reset();
+    if(gHTTPListener.isNull() == false)
+        gHTTPListener->close();
+    clsRequestHandler::stopAPIWorkers();
+    foreach(clsIOThread* IOThread, gIOThreads){
+        IOThread->stopListening();
+        delete IOThread;
+    }
+    gIOThreads.clear();
 #ifdef QHTTP_ENABLE_WEBSOCKET
     gWSServer.stopListening();
 #endif
+    clsUploadStorage::stop();
 
     gConfigs.Private.IsStarted = false;
+    gConfigs.Private.IsDraining.storeRelease(0);
     if(gStatUpdateThread)
         gStatUpdateThread->quit();
 }
 
+bool RESTServer::drain(quint32 _timeoutMSecs)
+{
+    if(gConfigs.Private.IsStarted == false)
+        return true;
+
+    gConfigs.Private.IsDraining.storeRelease(1);
+    gSocketHandoff.reset();
+    if(gHTTPListener.isNull() == false)
+        gHTTPListener->close();
+    foreach(clsIOThread* IOThread, gIOThreads)
+        IOThread->stopAccepting();
+
+    TargomanLogInfo(1, "Draining "<<clsRequestHandler::inFlightRequests()<<" in-flight request(s)");
+    QElapsedTimer Timer;
+    Timer.start();
+    while(clsRequestHandler::inFlightRequests() && Timer.elapsed() < static_cast<qint64>(_timeoutMSecs)){
+        /* Requests accepted on main thread must still be served while waiting */
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+        QThread::msleep(1);
+    }
+
+    quint32 Remaining = clsRequestHandler::inFlightRequests();
+    if(Remaining)
+        TargomanLogWarn(1, Remaining<<" in-flight request(s) were abandoned after drain timeout");
+
+    RESTServer::stop();
+    return Remaining == 0;
+}
+
 stuStatistics RESTServer::stats()
 {
-    return gServerStats;
+    stuStatistics Stats;
+    {
+        QMutexLocker Locker(&gServerStatsLock);
+        Stats = gServerStats;
+    }
+    Stats.APIQueueStats = clsRequestHandler::apiQueueStats();
+    Stats.UploadStorage = clsUploadStorage::stats();
+    return Stats;
+}
+
+size_t RESTServer::reloadIPBlockList()
+{
+    if(gConfigs.Public.IPBlockListFile.isEmpty()){
+        clsIPBlockList::clear();
+        return 0;
+    }
+    return clsIPBlockList::reload(gConfigs.Public.IPBlockListFile);
+}
+
+void RESTServer::claimUploadedFile(const QVariantMap& _file, const QString& _destination)
+{
+    clsUploadSpool::claim(_file, _destination);
 }
 
 QStringList RESTServer::registeredAPIs(bool _showParams, bool _showTypes, bool _prettifyTypes)
@@ -28,6 +28,7 @@
 #include <QScopedPointer>
 #include <QHostAddress>
 #include <QJsonObject>
+#include <QCryptographicHash>
 #include "libTargomanCommon/Macros.h"
 #include "QHttp/GenericTypes.h"
 
@@ -63,6 +64,10 @@ TARGOMAN_DEFINE_ENHANCED_ENUM(enuJWTHashAlgs,
  *        and then call start"()"
  *
  * @note  This class will create a small thread in oprder to update statistics.
+ * @note  When stuConfig::IOThreads is greater than one, requests will be handled on dedicated IO threads so all the APIs must be thread-safe
+ * @note  When stuConfig::APIWorkerThreads is set, APIs will be invoked on a separate worker pool so slow APIs will not block IO threads
+ * @note  When stuConfig::HandoffSocketPath is set, a newly started server will adopt listening sockets of the running one. The
+ *        older server then drains and quits the application so restarts will not refuse any connection
  */
 class RESTServer : public QObject
 {    
@@ -87,6 +92,26 @@ public:
         QString      CacheConnector;
         QString      AccessControl;
         QJsonObject BaseOpenAPIObject;
+        quint16      IOThreads = 1; ///< Number of event loops accepting and parsing HTTP requests. Values greater than one will use SO_REUSEPORT
+        quint16      APIWorkerThreads = 0; ///< Number of worker threads invoking APIs. Zero means APIs will be invoked on the IO thread handling the request
+        quint32      MaxInFlightRequests = 0; ///< Requests exceeding this number of concurrent requests will be rejected by 503. Zero means unlimited
+        quint32      MaxInFlightPerAPI = 0; ///< Same as MaxInFlightRequests but applied to each API separately
+        quint32      MaxQueueTimeMSecs = 0; ///< Requests waiting more than this on API worker queue will be rejected by 503. Zero means unlimited
+        quint16      RetryAfterSecs = 1; ///< Value of Retry-After header sent on rejected requests
+        quint32      RateLimitPerIP = 0; ///< Max requests per second (up to 4095) accepted from each client IP or IPv6 /64 prefix. Zero means unlimited
+        quint32      RateLimitPerIPRoute = 0; ///< Max requests per second accepted from each client IP on each API. Zero means unlimited
+        quint32      RateLimitPerConnection = 0; ///< Max requests per second accepted on each keep-alive connection. Zero means unlimited
+        QString      HandoffSocketPath; ///< Unix socket used to pass listening sockets to a newer process on restart. Empty disables handoff
+        quint32      DrainTimeoutMSecs = 30000; ///< Max time to wait for in-flight requests when draining after a handoff
+        QString      IPBlockListFile; ///< File of `CIDR [Ok|Banned|Restricted]` lines checked before fnIPInBlackList. Status defaults to Banned
+        qint64       UploadMemoryThreshold = 256 * 1024; ///< Uploaded files up to this size are passed to APIs in memory (base64 `data`) instead of a temporary file
+        QString      UploadDirectory; ///< Directory of anonymous files spooling larger uploads. Must be on the same filesystem as claim destinations to avoid copies. Empty means system temp
+        QList<QCryptographicHash::Algorithm> UploadDigests; ///< Digests computed while receiving uploaded files and passed to APIs as `digest` map of file info
+        QString      UploadStoreDirectory; ///< Content-addressed store of uploaded files keyed by SHA-256. Duplicates are linked to the stored copy instead of being stored again. Empty disables the store
+        qint64       MaxUploadedBytesPerRequest = 0; ///< Max sum of uploaded file sizes accepted on a single request. Zero means unlimited
+        qint64       MaxSpooledUploadBytes = 0; ///< Max disk space used by spool files of all in-flight uploads. Uploads exceeding it are rejected by 507. Zero means unlimited
+        qint64       BodyStreamBufferSize = 1024 * 1024; ///< Reading body of APIs accepting QHttp::BodyStream_t is paused while this many bytes are not consumed by the API
+        quint32      BodyStreamPauseTimeoutMSecs = 60000; ///< Max time reading body of a streaming API stays paused while the API does not consume it. Body stream is aborted and connection is closed afterwards. Zero means unlimited
 
 #ifdef QHTTP_ENABLE_WEBSOCKET
         QString WebSocketServerName;
@@ -114,6 +139,14 @@ public:
      */
     static void stop();
 
+    /**
+     * @brief drain will stop accepting new connections, wait for in-flight requests to finish (or the timeout to expire)
+     *        and then stop the server. Responses sent while draining will close their connection.
+     * @param _timeoutMSecs max time to wait for in-flight requests
+     * @return true if all in-flight requests were finished before timeout
+     */
+    static bool drain(quint32 _timeoutMSecs);
+
     /**
      * @brief shutdown will shutdown server and remove any timer and allocated resources
      */
@@ -125,6 +158,22 @@ public:
      */
     static QHttp::stuStatistics stats();
 
+    /**
+     * @brief reloadIPBlockList will reload IPBlockListFile and atomically replace the active block list. Can be called while
+     *        server is listening
+     * @return number of prefixes loaded
+     */
+    static size_t reloadIPBlockList();
+
+    /**
+     * @brief claimUploadedFile stores an uploaded file passed to an API (as a map of id, name, size, type and either data or
+     *        tmpname) on _destination. The file is found by its id among files uploaded by the request of the calling API
+     *        so other fields of the map are not trusted. Spooled and stored files are linked without copying when on the
+     *        same filesystem. Must be called by the API before it returns as unclaimed uploads are discarded when the
+     *        request finishes. Files kept on UploadStoreDirectory are never removed from the store
+     */
+    static void claimUploadedFile(const QVariantMap& _file, const QString& _destination);
+
     /**
      * @brief registeredAPIs will return a list of all auto-registered API calls
      * @param _showParams if set to `true` will list API parameters else just API name will be output
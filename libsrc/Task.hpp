@@ -0,0 +1,217 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S. Mehran M. Ziabary <ziabary@targoman.com>
+ */
+
+#ifndef QHTTP_TASK_HPP
+#define QHTTP_TASK_HPP
+
+#ifdef QHTTP_ENABLE_COROUTINES
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <utility>
+#include <QVariant>
+#include <QRunnable>
+#include <QThreadPool>
+#include "libTargomanCommon/exTargomanBase.h"
+
+namespace QHttp {
+
+TARGOMAN_ADD_EXCEPTION_HANDLER(exTaskCancelled, Targoman::Common::exTargomanBase);
+
+/**
+ * @brief The intfTaskContext class is implemented by request handlers in order to resume coroutines on the thread owning
+ *        the connection and to inform them when client has been disconnected
+ */
+class intfTaskContext{
+public:
+    virtual ~intfTaskContext(){}
+    virtual void resume(std::coroutine_handle<> _handle) = 0;
+    virtual void resumeAfter(std::coroutine_handle<> _handle, int _msecs) = 0;
+    virtual bool isCancelled() = 0;
+};
+
+/**
+ * @brief The Task class is the return type of coroutine APIs. Such APIs are defined using API macro with `QHttp::Task` as their
+ *        return type and can `co_await` other tasks, delay"()", runInThreadPool"()" or centralCacheValue"()" without blocking any
+ *        thread. The value passed to `co_return` will be sent as API result. Coroutines are always resumed on the IO thread owning
+ *        the connection and when client disconnects next `co_await` will throw exTaskCancelled.
+ */
+class Task{
+public:
+    struct promise_type;
+    typedef std::coroutine_handle<promise_type> Handle_t;
+
+    struct promise_type{
+        QVariant                                     Result;
+        std::exception_ptr                           Exception;
+        std::coroutine_handle<>                      Continuation;
+        intfTaskContext*                             Context = nullptr;
+        std::function<void(promise_type& _promise)>  OnDone;
+
+        Task get_return_object() { return Task(Handle_t::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        auto final_suspend() noexcept {
+            struct stuFinalAwaiter{
+                bool await_ready() noexcept { return false; }
+                std::coroutine_handle<> await_suspend(Handle_t _handle) noexcept {
+                    promise_type& Promise = _handle.promise();
+                    if(Promise.Continuation)
+                        return Promise.Continuation;
+                    if(Promise.OnDone)
+                        Promise.OnDone(Promise);
+                    _handle.destroy();
+                    return std::noop_coroutine();
+                }
+                void await_resume() noexcept {}
+            };
+            return stuFinalAwaiter{};
+        }
+        void return_value(QVariant _value) { this->Result = std::move(_value); }
+        void unhandled_exception() { this->Exception = std::current_exception(); }
+    };
+
+public:
+    Task() {}
+    Task(Task&& _other) noexcept : Coroutine(std::exchange(_other.Coroutine, nullptr)) {}
+    Task& operator = (Task&& _other) noexcept {
+        if(this != &_other){
+            if(this->Coroutine)
+                this->Coroutine.destroy();
+            this->Coroutine = std::exchange(_other.Coroutine, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator = (const Task&) = delete;
+    ~Task() {
+        if(this->Coroutine)
+            this->Coroutine.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(Handle_t _caller) noexcept {
+        this->Coroutine.promise().Context = _caller.promise().Context;
+        this->Coroutine.promise().Continuation = _caller;
+        return this->Coroutine;
+    }
+    QVariant await_resume() {
+        if(this->Coroutine.promise().Exception)
+            std::rethrow_exception(this->Coroutine.promise().Exception);
+        return std::move(this->Coroutine.promise().Result);
+    }
+
+    /**
+     * @brief start detaches coroutine from this object and schedules it on the context. The frame will destroy itself after
+     *        calling _onDone
+     */
+    void start(intfTaskContext* _context, const std::function<void(promise_type& _promise)>& _onDone){
+        Handle_t Handle = std::exchange(this->Coroutine, nullptr);
+        Handle.promise().Context = _context;
+        Handle.promise().OnDone = _onDone;
+        _context->resume(Handle);
+    }
+
+private:
+    explicit Task(Handle_t _handle) : Coroutine(_handle) {}
+
+private:
+    Handle_t Coroutine = nullptr;
+};
+
+/**
+ * @brief The stuDelayAwaiter struct resumes the coroutine after specified milliseconds using IO thread event loop
+ */
+struct stuDelayAwaiter{
+    int              Msecs;
+    intfTaskContext* Context = nullptr;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(Task::Handle_t _caller) {
+        this->Context = _caller.promise().Context;
+        this->Context->resumeAfter(_caller, this->Msecs);
+    }
+    void await_resume() {
+        if(this->Context->isCancelled())
+            throw exTaskCancelled("Client disconnected");
+    }
+};
+
+/**
+ * @brief The clsThreadPoolAwaiter class runs a blocking job (e.g. DB call) on global thread pool and resumes the coroutine
+ *        on the IO thread with its result
+ */
+class clsThreadPoolAwaiter{
+public:
+    clsThreadPoolAwaiter(const std::function<QVariant()>& _job) :
+        Job(_job)
+    {}
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(Task::Handle_t _caller) {
+        this->Context = _caller.promise().Context;
+        QThreadPool::globalInstance()->start(new clsRunnable(this, _caller));
+    }
+    QVariant await_resume() {
+        if(this->Context->isCancelled())
+            throw exTaskCancelled("Client disconnected");
+        if(this->Exception)
+            std::rethrow_exception(this->Exception);
+        return std::move(this->Result);
+    }
+
+private:
+    class clsRunnable : public QRunnable{
+    public:
+        clsRunnable(clsThreadPoolAwaiter* _awaiter, std::coroutine_handle<> _caller) :
+            Awaiter(_awaiter),
+            Caller(_caller)
+        {}
+        void run() final {
+            try{
+                this->Awaiter->Result = this->Awaiter->Job();
+            }catch(...){
+                this->Awaiter->Exception = std::current_exception();
+            }
+            this->Awaiter->Context->resume(this->Caller);
+        }
+    private:
+        clsThreadPoolAwaiter*   Awaiter;
+        std::coroutine_handle<> Caller;
+    };
+
+private:
+    std::function<QVariant()> Job;
+    QVariant                  Result;
+    std::exception_ptr        Exception;
+    intfTaskContext*          Context = nullptr;
+};
+
+inline stuDelayAwaiter delay(int _msecs) { return stuDelayAwaiter{_msecs}; }
+inline clsThreadPoolAwaiter runInThreadPool(const std::function<QVariant()>& _job) { return clsThreadPoolAwaiter(_job); }
+extern clsThreadPoolAwaiter centralCacheValue(const QString& _key);
+
+}
+
+#endif // QHTTP_ENABLE_COROUTINES
+#endif // QHTTP_TASK_HPP
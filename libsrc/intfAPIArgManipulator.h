@@ -38,11 +38,11 @@ enum enuVarComplexity {
 };
 
 class intfCacheConnector;
+class intfAPIInvoker;
 /**********************************************************************/
 class intfAPIObject{
 public:
     virtual ~intfAPIObject();
-    virtual void invokeMethod(const QVariantList& _arguments, QGenericReturnArgument _returnArg) const = 0;
 };
 
 /**********************************************************************/
@@ -51,9 +51,25 @@ public:
     intfAPIArgManipulator(const QString& _realTypeName);
     virtual ~intfAPIArgManipulator();
 
-    virtual QGenericArgument makeGenericArgument(const QVariant& _val, const QByteArray& _paramName, void** _argStorage) = 0;
-    virtual QVariant invokeMethod(const intfAPIObject* _apiObject, const QVariantList& _arguments) = 0;
+    /**
+     * @brief fromString constructs the argument in place on _argStorage from its raw value as received in path, query or
+     *        form body. _argStorage must be at least storageSize"()" bytes and aligned to storageAlignment"()". Constructed
+     *        arguments must be destroyed by cleanup"()"
+     */
+    virtual void fromString(const QString& _value, const QByteArray& _paramName, void* _argStorage) = 0;
+    /**
+     * @brief constructArgument constructs the argument same as fromString"()" from values which are not strings such as
+     *        parsed JSON values and default values
+     */
+    virtual void constructArgument(const QVariant& _val, const QByteArray& _paramName, void* _argStorage) = 0;
+    /**
+     * @brief invoke calls the API through its typed invoker storing result in an instance of this type. Result is
+     *        converted to QVariant just to be serialized
+     */
+    virtual QVariant invoke(const intfAPIInvoker* _invoker, void* const* _args, int _count) = 0;
     virtual void cleanup (void* _argStorage) = 0;
+    virtual size_t storageSize() = 0;
+    virtual size_t storageAlignment() = 0;
     virtual bool hasFromVariantMethod() = 0;
     virtual bool hasToVariantMethod() = 0;
     virtual QString toString(const QVariant _val) = 0;
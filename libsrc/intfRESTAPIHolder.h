@@ -31,6 +31,7 @@
 #include "QHttp/qhttpfwd.hpp"
 #include "QHttp/stuORMField.hpp"
 #include "QHttp/GenericTypes.h"
+#include "QHttp/tmplAPIInvoker.h"
 
 namespace QHttp {
 /**********************************************************************/
@@ -77,8 +78,50 @@ namespace QHttp {
 #  define CENTRALCACHE_24H
 #endif
 
-#define API(_method, _name, _sig, _doc) api##_method##_name _sig; QString signOf##_method##_name(){ return #_sig; } QString docOf##_method##_name(){ return #_doc; }
-#define ASYNC_API(_method, _name, _sig, _doc) asyncApi##_method##_name _sig;QString signOf##_method##_name(){ return #_sig; } QString docOf##_method##_name(){ return #_doc; }
+/**
+  * @brief MAXBODY macros are predefined macros in order to mark maximum request body size accepted by each API. When defined it
+  *        overrides RESTServer::stuConfig::MaxUploadSize for that API. You can add more sizes as you wish while following
+  *        definition pattern "\d+(K|M|G)" where last character means K: KiB, M: MiB, G: GiB
+  */
+#ifndef Q_MOC_RUN
+#  define MAXBODY_1K
+#  define MAXBODY_10K
+#  define MAXBODY_100K
+#  define MAXBODY_1M
+#  define MAXBODY_10M
+#  define MAXBODY_100M
+#  define MAXBODY_1G
+#  define MAXBODY_10G
+#endif
+
+/**
+  * @brief QHTTP_API_INVOKER defines invokerOf<API> slot which returns typed invoker of the API. The caller struct is hidden
+  *        from moc as it is placed in slots section so moc just sees declaration of the invoker slot
+  */
+#ifdef Q_MOC_RUN
+#  define QHTTP_API_INVOKER(_prefix, _method, _name) QHttp::intfAPIInvoker* invokerOf##_method##_name();
+#else
+#  define QHTTP_API_INVOKER(_prefix, _method, _name) \
+    struct stuCallerOf##_method##_name{ \
+        template<typename _itmplObject, typename... _itmplArgs> \
+        static auto call(_itmplObject* _object, _itmplArgs&... _args) -> decltype(_object->_prefix##_method##_name(_args...)){ \
+            return _object->_prefix##_method##_name(_args...); \
+        } \
+    }; \
+    QHttp::intfAPIInvoker* invokerOf##_method##_name(){ \
+        return QHttp::makeAPIInvoker<stuCallerOf##_method##_name>( \
+                    this, &std::remove_pointer<decltype(this)>::type::_prefix##_method##_name); \
+    }
+#endif
+
+#define API(_method, _name, _sig, _doc) api##_method##_name _sig; QString signOf##_method##_name(){ return #_sig; } QString docOf##_method##_name(){ return #_doc; } \
+    QHTTP_API_INVOKER(api, _method, _name)
+/**
+  * @brief ASYNC_API marks an API which responds through a QHttp::AsyncResponse_t parameter. Such APIs can return void and the
+  *        connection will be kept open until the completion handle is resolved or rejected.
+  */
+#define ASYNC_API(_method, _name, _sig, _doc) asyncApi##_method##_name _sig;QString signOf##_method##_name(){ return #_sig; } QString docOf##_method##_name(){ return #_doc; } \
+    QHTTP_API_INVOKER(asyncApi, _method, _name)
 
 /**********************************************************************/
 /**
@@ -28,7 +28,9 @@ DIST_HEADERS += \
     GenericTypes.h \
     intfAPIArgManipulator.h \
     tmplAPIArg.h \
+    tmplAPIInvoker.h \
     stuORMField.hpp \
+    Task.hpp \
 
 PRIVATE_HEADERS += \
     Private/intfCacheConnector.hpp \
@@ -43,6 +45,19 @@ PRIVATE_HEADERS += \
     Private/WebSocketServer.hpp \
     Private/QJWT.h \
     Private/clsSimpleCrypt.h \
+    Private/clsIOThread.h \
+    Private/clsAPIExecutor.h \
+    Private/clsRateLimiter.h \
+    Private/clsIPBlockList.h \
+    Private/clsSocketHandoff.h \
+    Private/clsRouteTable.h \
+    Private/clsQueryArgs.h \
+    Private/clsJSONEngine.h \
+    Private/clsPercentDecoder.h \
+    Private/clsMultipartParser.h \
+    Private/clsUploadSpool.h \
+    Private/clsUploadStorage.h \
+    Private/clsBodyStream.h \
 
 
 # +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-#
@@ -54,7 +69,20 @@ SOURCES += \
     Private/clsRedisConnector.cpp \
     Private/QJWT.cpp \
     Private/clsSimpleCrypt.cpp \
-    Private/GenericTypes.cpp
+    Private/GenericTypes.cpp \
+    Private/clsIOThread.cpp \
+    Private/clsAPIExecutor.cpp \
+    Private/clsRateLimiter.cpp \
+    Private/clsIPBlockList.cpp \
+    Private/clsSocketHandoff.cpp \
+    Private/clsRouteTable.cpp \
+    Private/clsQueryArgs.cpp \
+    Private/clsJSONEngine.cpp \
+    Private/clsPercentDecoder.cpp \
+    Private/clsMultipartParser.cpp \
+    Private/clsUploadSpool.cpp \
+    Private/clsUploadStorage.cpp \
+    Private/clsBodyStream.cpp
 
 # +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-#
 OTHER_FILES += \
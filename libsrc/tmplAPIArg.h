@@ -24,8 +24,11 @@
 #ifndef QHTTP_TMPLAPIARG_HPP
 #define QHTTP_TMPLAPIARG_HPP
 
+#include <new>
+#include <type_traits>
 #include "HTTPExceptions.h"
 #include "intfAPIArgManipulator.h"
+#include "tmplAPIInvoker.h"
 
 namespace QHttp {
 namespace Private {
@@ -47,18 +50,21 @@ public:
     {}
     virtual ~tmplAPIArg(){;}
 
-    virtual QGenericArgument makeGenericArgument(const QVariant& _val, const QByteArray& _paramName, void** _argStorage) final{
-        *_argStorage = nullptr;
+    virtual void constructArgument(const QVariant& _val, const QByteArray& _paramName, void* _argStorage) final{
         if(this->fromVariant == nullptr && !_val.canConvert<_itmplType>())
                 throw exHTTPBadRequest("Invalid value specified for parameter: " + _paramName);
-        *_argStorage = new _itmplType;
-        *(reinterpret_cast<_itmplType*>(*_argStorage)) =
-                this->fromVariant == nullptr ? _val.value<_itmplType>() : this->fromVariant(_val, _paramName);
-        return QGenericArgument(this->RealTypeName, *_argStorage);
+        new (_argStorage) _itmplType(this->fromVariant == nullptr ? _val.value<_itmplType>() : this->fromVariant(_val, _paramName));
     }
-    inline QVariant invokeMethod(const intfAPIObject *_apiObject, const QVariantList& _arguments) final {
+    virtual void fromString(const QString& _value, const QByteArray& _paramName, void* _argStorage) final{
+        if(this->fromVariant)
+            new (_argStorage) _itmplType(this->fromVariant(_value, _paramName));
+        else
+            this->constructFromString(_value, _paramName, _argStorage, std::is_same<_itmplType, QString>());
+    }
+    inline QVariant invoke(const intfAPIInvoker* _invoker, void* const* _args, int _count) final {
            _itmplType Result;
-           _apiObject->invokeMethod(_arguments, QReturnArgument<_itmplType >(this->RealTypeName, Result));
+           if(_invoker->invoke(_args, _count, &Result) == false)
+               throw exHTTPInternalServerError(QString("Unable to invoke method"));
            return this->toVariant == nullptr ? QVariant::fromValue(Result) : this->toVariant(Result);
     }
     inline void validate(const QVariant& _val, const QByteArray& _paramName) final {
@@ -67,7 +73,9 @@ public:
         if(this->fromVariant)
             this->fromVariant(_val, _paramName);
     }
-    inline void cleanup (void* _argStorage) final {if(_argStorage) delete (reinterpret_cast<_itmplType*>(_argStorage));}
+    inline void cleanup (void* _argStorage) final {reinterpret_cast<_itmplType*>(_argStorage)->~_itmplType();}
+    inline size_t storageSize() final {return sizeof(_itmplType);}
+    inline size_t storageAlignment() final {return alignof(_itmplType);}
     inline bool hasFromVariantMethod() final {return this->fromVariant != nullptr;}
     inline bool hasToVariantMethod() final {return this->toVariant != nullptr;}
     inline bool isIntegralType() final { return _itmplVarType == COMPLEXITY_Integral;}
@@ -80,6 +88,14 @@ public:
         return QString();
     }
 
+private:
+    inline void constructFromString(const QString& _value, const QByteArray&, void* _argStorage, std::true_type){
+        new (_argStorage) _itmplType(_value);
+    }
+    inline void constructFromString(const QString& _value, const QByteArray& _paramName, void* _argStorage, std::false_type){
+        this->constructArgument(_value, _paramName, _argStorage);
+    }
+
 private:
     std::function<QVariant(_itmplType _value)> toVariant;
     std::function<_itmplType(QVariant _value, const QByteArray& _paramName)> fromVariant;
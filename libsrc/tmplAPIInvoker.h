@@ -0,0 +1,136 @@
+/*******************************************************************************
+ * QRESTServer a lean and mean Qt/C++ based REST server                        *
+ *                                                                             *
+ * Copyright 2018 by Targoman Intelligent Processing Co Pjc.<http://tip.co.ir> *
+ *                                                                             *
+ *                                                                             *
+ * QRESTServer is free software: you can redistribute it and/or modify         *
+ * it under the terms of the GNU AFFERO GENERAL PUBLIC LICENSE as published by *
+ * the Free Software Foundation, either version 3 of the License, or           *
+ * (at your option) any later version.                                         *
+ *                                                                             *
+ * QRESTServer is distributed in the hope that it will be useful,              *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ * GNU AFFERO GENERAL PUBLIC LICENSE for more details.                         *
+ * You should have received a copy of the GNU AFFERO GENERAL PUBLIC LICENSE    *
+ * along with QRESTServer. If not, see <http://www.gnu.org/licenses/>.         *
+ *                                                                             *
+ *******************************************************************************/
+/**
+ * @author S.Mehran M.Ziabary <ziabary@targoman.com>
+ */
+
+#ifndef QHTTP_TMPLAPIINVOKER_H
+#define QHTTP_TMPLAPIINVOKER_H
+
+#include <cstddef>
+#include <type_traits>
+#include <tuple>
+#include <utility>
+#include <QtGlobal>
+
+namespace QHttp {
+
+/**********************************************************************/
+/**
+ * @brief The intfAPIInvoker class is a type-erased thunk which calls an API slot directly with typed arguments. Instances are
+ *        generated by API macros so that APIs are not invoked through QMetaMethod and the number of their params is not limited.
+ */
+class intfAPIInvoker{
+public:
+    virtual ~intfAPIInvoker(){}
+    /**
+     * @brief invoke calls the API with the first _count arguments. Omitted trailing params get their C++ default values as
+     *        the call is compiled by API macros in scope of the API declaration
+     * @param _args array of pointers to arguments each one pointing to an instance of decayed type of its parameter
+     * @param _count number of arguments in _args
+     * @param _result pointer to an instance of API return type to store the result or nullptr to ignore result
+     * @return false if the API can not be called with _count arguments
+     */
+    virtual bool invoke(void* const* _args, int _count, void* _result) const = 0;
+    virtual int paramsCount() const = 0;
+};
+
+/**********************************************************************/
+/**
+ * @brief The tmplAPIInvoker class dispatches on the number of provided arguments to a call generated for each prefix of the
+ *        API params. _itmplCaller::call is generated by API macros and calls the slot by name so defaults are applied.
+ */
+template<typename _itmplCaller, typename _itmplClass, typename _itmplReturn, typename... _itmplArgs>
+class tmplAPIInvoker : public intfAPIInvoker{
+    template<std::size_t _itmplIndex>
+    using ArgType = typename std::decay<typename std::tuple_element<_itmplIndex, std::tuple<_itmplArgs...>>::type>::type;
+    typedef bool (*CallPtr_t)(_itmplClass*, void* const*, void*);
+
+public:
+    tmplAPIInvoker(_itmplClass* _object) :
+        Object(_object)
+    {}
+
+    bool invoke(void* const* _args, int _count, void* _result) const final {
+        return this->dispatch(_args, _count, _result, std::make_index_sequence<sizeof...(_itmplArgs) + 1>());
+    }
+    int paramsCount() const final { return sizeof...(_itmplArgs); }
+
+private:
+    template<std::size_t... _itmplCounts>
+    inline bool dispatch(void* const* _args, int _count, void* _result, std::index_sequence<_itmplCounts...>) const{
+        static const CallPtr_t Calls[] = { &tmplAPIInvoker::callWith<_itmplCounts>... };
+        if(_count < 0 || _count > static_cast<int>(sizeof...(_itmplArgs)))
+            return false;
+        return Calls[_count](this->Object, _args, _result);
+    }
+
+    template<std::size_t _itmplCount>
+    static bool callWith(_itmplClass* _object, void* const* _args, void* _result){
+        return tmplAPIInvoker::callIndexes(_object, _args, _result, std::make_index_sequence<_itmplCount>());
+    }
+
+    template<std::size_t... _itmplIndexes>
+    static bool callIndexes(_itmplClass* _object, void* const* _args, void* _result, std::index_sequence<_itmplIndexes...>){
+        Q_UNUSED(_args)
+        return tmplAPIInvoker::call(0, _object, _result, *static_cast<ArgType<_itmplIndexes>*>(_args[_itmplIndexes])...);
+    }
+
+    /* Selected when the API can be called with given arguments i.e. all the omitted params have default values */
+    template<typename... _itmplGiven>
+    static auto call(int, _itmplClass* _object, void* _result, _itmplGiven&... _given)
+        -> decltype(_itmplCaller::call(_object, _given...), bool()){
+        tmplAPIInvoker::store(_result, std::is_void<_itmplReturn>(), [&](){ return _itmplCaller::call(_object, _given...); });
+        return true;
+    }
+    template<typename... _itmplGiven>
+    static bool call(long, _itmplClass*, void*, _itmplGiven&...){
+        return false;
+    }
+
+    template<typename _itmplLambda>
+    static inline void store(void*, std::true_type, _itmplLambda _call){
+        _call();
+    }
+    template<typename _itmplLambda>
+    static inline void store(void* _result, std::false_type, _itmplLambda _call){
+        if(_result)
+            *static_cast<_itmplReturn*>(_result) = _call();
+        else
+            _call();
+    }
+
+private:
+    _itmplClass*  Object;
+};
+
+template<typename _itmplCaller, typename _itmplClass, typename _itmplReturn, typename... _itmplArgs>
+intfAPIInvoker* makeAPIInvoker(_itmplClass* _object, _itmplReturn (_itmplClass::*)(_itmplArgs...)){
+    return new tmplAPIInvoker<_itmplCaller, _itmplClass, _itmplReturn, _itmplArgs...>(_object);
+}
+
+template<typename _itmplCaller, typename _itmplClass, typename _itmplReturn, typename... _itmplArgs>
+intfAPIInvoker* makeAPIInvoker(_itmplClass* _object, _itmplReturn (_itmplClass::*)(_itmplArgs...) const){
+    return new tmplAPIInvoker<_itmplCaller, _itmplClass, _itmplReturn, _itmplArgs...>(_object);
+}
+
+}
+
+#endif // QHTTP_TMPLAPIINVOKER_H
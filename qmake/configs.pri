@@ -34,6 +34,10 @@ DEFINES += TARGOMAN_SHOW_NORMAL=1
 #Comment this in order to disable redis integration
 CONFIG += enable_redis
 CONFIG += enable_websocket
+#Uncomment this in order to enable C++20 coroutine APIs (QHttp::Task)
+#CONFIG += enable_coroutines
+#Uncomment this in order to parse JSON input by simdjson (requires libsimdjson and a C++17 compiler)
+#CONFIG += enable_simdjson
 
 DEFINES += PROJ_VERSION=$$VERSION
 
@@ -113,3 +117,14 @@ CONFIG(enable_websocket) {
 DEFINES += QHTTP_ENABLE_WEBSOCKET=1
 QT+= websockets
 }
+
+CONFIG(enable_coroutines) {
+DEFINES += QHTTP_ENABLE_COROUTINES=1
+QMAKE_CXXFLAGS += -std=c++2a -fcoroutines
+}
+
+CONFIG(enable_simdjson) {
+DEFINES += QHTTP_ENABLE_SIMDJSON=1
+LIBS += -lsimdjson
+!CONFIG(enable_coroutines): QMAKE_CXXFLAGS += -std=c++17
+}
@@ -22,10 +22,246 @@
  * @author S.Mehran M.Ziabary <ziabary@targoman.com>
  */
 
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QElapsedTimer>
 #include "UnitTest.h"
+#include "Private/clsJSONEngine.h"
+#include "Private/clsMultipartParser.h"
+#include "Private/clsRouteTable.h"
+#include "Private/clsQueryArgs.h"
+#include "Private/clsPercentDecoder.h"
+
+using namespace QHttp::Private;
 
 void UnitTest::initTestCase(){
 }
 
+void UnitTest::benchJSONParse_data()
+{
+    QJsonObject Flat;
+    for(int i = 0; i < 20; ++i)
+        Flat.insert(QString("field%1").arg(i), i % 2 ? QJsonValue(QString("value of field %1").arg(i)) : QJsonValue(i * 1.5));
+
+    QJsonArray Records;
+    for(int i = 0; i < 1000; ++i)
+        Records.append(QJsonObject({{"id", i}, {"name", QString("item-%1").arg(i)}, {"active", i % 3 == 0},
+                                    {"tags", QJsonArray({"a", "b", "c"})}, {"price", i * 0.25}}));
+
+    QJsonObject JWTPayload({{"iat", 1571200000}, {"exp", 1571203600}, {"usrID", 1234}, {"email", "user@example.com"},
+                            {"privs", QJsonObject({{"ALL", QJsonObject({{"CRUD", "1111"}})}})}});
+
+    QTest::addColumn<bool>("useEngine");
+    QTest::addColumn<QByteArray>("payload");
+
+    QList<QPair<const char*, QByteArray>> Payloads = {
+        {"flat-object",   QJsonDocument(Flat).toJson(QJsonDocument::Compact)},
+        {"records-array", QJsonDocument(QJsonObject({{"items", Records}})).toJson(QJsonDocument::Compact)},
+        {"jwt-payload",   QJsonDocument(JWTPayload).toJson(QJsonDocument::Compact)},
+    };
+    foreach(auto Payload, Payloads){
+        QTest::newRow(QByteArray("QJsonDocument/") + Payload.first) << false << Payload.second;
+#ifdef QHTTP_ENABLE_SIMDJSON
+        QTest::newRow(QByteArray(clsJSONEngine::name()) + "/" + Payload.first) << true << Payload.second;
+#endif
+    }
+}
+
+void UnitTest::benchJSONParse()
+{
+    QFETCH(bool, useEngine);
+    QFETCH(QByteArray, payload);
+
+    if(useEngine){
+        QVERIFY(clsJSONEngine::parse(payload).isObject());
+        QCOMPARE(clsJSONEngine::parse(payload), QJsonDocument::fromJson(payload));
+        QBENCHMARK{
+            clsJSONEngine::parse(payload);
+        }
+    }else{
+        QVERIFY(QJsonDocument::fromJson(payload).isObject());
+        QBENCHMARK{
+            QJsonDocument::fromJson(payload);
+        }
+    }
+}
+
+class clsMultipartCounter : public clsMultipartParser{
+public:
+    clsMultipartCounter() : clsMultipartParser("----WebKitFormBoundaryYiAlZ6r6wOTlubUC") {}
+    int     Parts = 0;
+    qint64  Bytes = 0;
+private:
+    void onPartBegin(const stuMultipartHeaders&) Q_DECL_FINAL { ++this->Parts; }
+    void onPartData(const char*, size_t _size) Q_DECL_FINAL { this->Bytes += static_cast<qint64>(_size); }
+    void onPartEnd() Q_DECL_FINAL {}
+    void onEnd() Q_DECL_FINAL {}
+};
+
+void UnitTest::benchMultipartParse_data()
+{
+    QTest::addColumn<int>("chunkSize");
+    QTest::newRow("4KiB chunks")  << 4 * 1024;
+    QTest::newRow("64KiB chunks") << 64 * 1024;
+    QTest::newRow("single chunk") << 0;
+}
+
+void UnitTest::benchMultipartParse()
+{
+    QFETCH(int, chunkSize);
+
+    QFile Fixture(QFINDTESTDATA("../Doc/multipart.bin"));
+    QVERIFY(Fixture.open(QIODevice::ReadOnly));
+    /* Fixture is a raw HTTP capture so just the first multipart body (up to its close delimiter) is parsed */
+    QByteArray Data = Fixture.readAll();
+    const QByteArray CloseDelimiter = "------WebKitFormBoundaryYiAlZ6r6wOTlubUC--";
+    int BodyEnd = Data.indexOf(CloseDelimiter);
+    QVERIFY(BodyEnd > 0);
+    Data.truncate(BodyEnd + CloseDelimiter.size());
+    if(chunkSize == 0)
+        chunkSize = Data.size();
+
+    auto parse = [&](){
+        clsMultipartCounter Parser;
+        qint64 Consumed = 0;
+        for(int Pos = 0; Pos < Data.size() && Parser.stopped() == false; Pos += chunkSize)
+            Consumed += static_cast<qint64>(Parser.feed(Data.constData() + Pos, static_cast<size_t>(qMin(chunkSize, Data.size() - Pos))));
+        return Parser.succeeded() && Consumed == Data.size() ? Parser.Parts : -1;
+    };
+
+    QCOMPARE(parse(), 7);
+
+    /* Throughput is reported against the parsed bytes instead of QBENCHMARK time per iteration */
+    QElapsedTimer Timer;
+    qint64 Iterations = 0;
+    Timer.start();
+    do{
+        parse();
+        ++Iterations;
+    }while(Timer.elapsed() < 1000);
+    QTest::setBenchmarkResult(static_cast<qreal>(Data.size()) * Iterations * 1e9 / Timer.nsecsElapsed(), QTest::BytesPerSecond);
+}
+
+void UnitTest::routeTable_data()
+{
+    QTest::addColumn<QString>("path");
+    QTest::addColumn<int>("api");
+    QTest::addColumn<QString>("extraPath");
+
+    QTest::newRow("exact")                      << "/mod/api"          << 1 << "";
+    QTest::newRow("exact with trailing slash")  << "/mod/api/"         << 1 << "";
+    QTest::newRow("extra path")                 << "/mod/api/123"      << 1 << "123";
+    QTest::newRow("extra path trailing slash")  << "/mod/api/123/"     << 1 << "123";
+    QTest::newRow("template")                   << "/mod/item/7"       << 2 << "7";
+    QTest::newRow("template trailing slash")    << "/mod/item/7/"      << 2 << "7";
+    QTest::newRow("empty segment")              << "/mod//api"         << 0 << "";
+    QTest::newRow("two extra segments")         << "/mod/api/123/456"  << 0 << "";
+    QTest::newRow("unknown")                    << "/mod/unknown/1"    << 0 << "";
+}
+
+void UnitTest::routeTable()
+{
+    QFETCH(QString, path);
+    QFETCH(int, api);
+    QFETCH(QString, extraPath);
+
+    clsAPIObject* APIs[] = { nullptr, reinterpret_cast<clsAPIObject*>(quintptr(8)), reinterpret_cast<clsAPIObject*>(quintptr(16)) };
+    clsRouteTable Routes;
+    Routes.add(ROUTE_GET, "/mod/api", APIs[1]);
+    Routes.add(ROUTE_GET, "/mod/item/{id}", APIs[2]);
+    Routes.compile();
+
+    QString ExtraPath;
+    PathArgs_t PathArgs;
+    QCOMPARE(Routes.find(ROUTE_GET, path, &ExtraPath, &PathArgs), APIs[api]);
+    if(api){
+        QCOMPARE(ExtraPath, extraPath);
+        QCOMPARE(PathArgs.size(), api == 2 ? 1 : 0);
+        if(PathArgs.size()){
+            QCOMPARE(PathArgs.at(0).ParamIndex, quint8(0));
+            QCOMPARE(PathArgs.at(0).Value, extraPath);
+        }
+    }
+    QVERIFY(Routes.find(ROUTE_POST, path) == nullptr);
+}
+
+void UnitTest::queryArgs_data()
+{
+    QTest::addColumn<QByteArray>("query");
+    QTest::addColumn<QByteArray>("name");
+    QTest::addColumn<bool>("found");
+    QTest::addColumn<QString>("value");
+
+    QTest::newRow("plain")              << QByteArray("a=1&b=2")      << QByteArray("b")    << true  << "2";
+    QTest::newRow("encoded value")      << QByteArray("q=a%20b+c")    << QByteArray("q")    << true  << "a b c";
+    QTest::newRow("encoded name")       << QByteArray("na%6De=x")     << QByteArray("name") << true  << "x";
+    QTest::newRow("utf8 value")         << QByteArray("q=%D8%B3%D9%84%D8%A7%D9%85") << QByteArray("q") << true
+                                        << QString::fromUtf8("\xD8\xB3\xD9\x84\xD8\xA7\xD9\x85");
+    QTest::newRow("first of repeated")  << QByteArray("a=1&a=2")      << QByteArray("a")    << true  << "1";
+    QTest::newRow("empty value")        << QByteArray("a=&b=1")       << QByteArray("a")    << true  << "";
+    QTest::newRow("empty pairs")        << QByteArray("&&a=1&")       << QByteArray("a")    << true  << "1";
+    QTest::newRow("without value")      << QByteArray("a&b=1")        << QByteArray("a")    << false << "";
+    QTest::newRow("missing")            << QByteArray("a=1")          << QByteArray("b")    << false << "";
+    QTest::newRow("empty query")        << QByteArray()               << QByteArray("a")    << false << "";
+}
+
+void UnitTest::queryArgs()
+{
+    QFETCH(QByteArray, query);
+    QFETCH(QByteArray, name);
+    QFETCH(bool, found);
+    QFETCH(QString, value);
+
+    clsQueryArgs Args(query);
+    int Index = Args.indexOf(name, clsQueryArgs::hash(name));
+    QCOMPARE(Index >= 0, found);
+    if(found){
+        QCOMPARE(Args.name(Index), QString::fromLatin1(name));
+        QCOMPARE(Args.value(Index), value);
+    }
+
+    /* Appended args are indexed the same as parsed ones */
+    Args.append("appended", "v");
+    int AppendedIndex = Args.indexOf("appended", clsQueryArgs::hash("appended"));
+    QVERIFY(AppendedIndex >= 0);
+    QCOMPARE(Args.value(AppendedIndex), QString("v"));
+}
+
+void UnitTest::percentDecoder_data()
+{
+    QTest::addColumn<QByteArray>("encoded");
+    QTest::addColumn<bool>("plusAsSpace");
+    QTest::addColumn<QByteArray>("decoded");
+
+    QTest::newRow("nothing to decode")  << QByteArray("abcdef")             << false << QByteArray("abcdef");
+    QTest::newRow("escape")             << QByteArray("a%20b")              << false << QByteArray("a b");
+    QTest::newRow("escape at end")      << QByteArray("ab%41")              << false << QByteArray("abA");
+    QTest::newRow("lower case hex")     << QByteArray("%2f%2F")             << false << QByteArray("//");
+    QTest::newRow("plus as space")      << QByteArray("a+b")                << true  << QByteArray("a b");
+    QTest::newRow("plus kept")          << QByteArray("a+b")                << false << QByteArray("a+b");
+    QTest::newRow("truncated escape")   << QByteArray("100%")               << false << QByteArray("100%");
+    QTest::newRow("short escape")       << QByteArray("%4")                 << false << QByteArray("%4");
+    QTest::newRow("invalid escape")     << QByteArray("%zz%41")             << false << QByteArray("%zzA");
+    QTest::newRow("long runs")          << QByteArray("0123456789abcdefghij%41klmnopqrstuvwxyz0123456789+%42")
+                                        << true  << QByteArray("0123456789abcdefghijAklmnopqrstuvwxyz0123456789 B");
+    QTest::newRow("escape in 2nd block")<< QByteArray("0123456789abcdef0123%2A")
+                                        << false << QByteArray("0123456789abcdef0123*");
+}
+
+void UnitTest::percentDecoder()
+{
+    QFETCH(QByteArray, encoded);
+    QFETCH(bool, plusAsSpace);
+    QFETCH(QByteArray, decoded);
+
+    QCOMPARE(clsPercentDecoder::decode(encoded.constData(), encoded.size(), plusAsSpace), decoded);
+    QCOMPARE(clsPercentDecoder::needsDecode(encoded.constData(), encoded.size(), plusAsSpace),
+             encoded.contains('%') || (plusAsSpace && encoded.contains('+')));
+    QCOMPARE(clsPercentDecoder::decodeToString(QString::fromLatin1(encoded), plusAsSpace), QString::fromLatin1(decoded));
+    /* Malformed escapes are kept verbatim the same as Qt does */
+    if(plusAsSpace == false)
+        QCOMPARE(clsPercentDecoder::decode(encoded.constData(), encoded.size(), false), QByteArray::fromPercentEncoding(encoded));
+}
+
 QTEST_MAIN(UnitTest)
 
@@ -32,6 +32,16 @@ class UnitTest: public QObject
 
 private slots:
     void initTestCase();
+    void benchJSONParse_data();
+    void benchJSONParse();
+    void benchMultipartParse_data();
+    void benchMultipartParse();
+    void routeTable_data();
+    void routeTable();
+    void queryArgs_data();
+    void queryArgs();
+    void percentDecoder_data();
+    void percentDecoder();
 };
 
 #endif // UNITTEST_H